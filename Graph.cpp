@@ -13,53 +13,159 @@
 
 #include "Graph.h"
 
-Graph::Graph(const std::vector<int> vertices_) : vertices(vertices_) { for (auto vertex: vertices) { originalVertices[vertex] = vertex; } }
+Graph::Graph(const std::vector<int> vertices_) : vertices(vertices_) { for (auto vertex: vertices) { registerVertex(vertex); } }
+
+int Graph::indexOf(int vertex) const {
+    const int slot = vertex - label_offset;
+    if (slot < 0 || slot >= static_cast<int>(index_of_label.size())) return -1;
+    return index_of_label[slot];
+}
+
+int Graph::registerVertex(int vertex) {
+    const int existing = indexOf(vertex);
+    if (existing >= 0) return existing;
+
+    // Grow the label window so it covers the new label
+    if (index_of_label.empty()) {
+        label_offset = vertex;
+        index_of_label.assign(1, -1);
+    } else if (vertex < label_offset) {
+        index_of_label.insert(index_of_label.begin(), label_offset - vertex, -1);
+        label_offset = vertex;
+    } else if (vertex - label_offset >= static_cast<int>(index_of_label.size())) {
+        index_of_label.resize(vertex - label_offset + 1, -1);
+    }
+
+    const int index = label_of_index.size();
+    index_of_label[vertex - label_offset] = index;
+    label_of_index.push_back(vertex);
+    original_of_index.push_back(vertex);
+    if (index < kMaxBitsetVertices) adjacency_masks.push_back(0);
+    adjacency_built = false;
+    return index;
+}
+
+void Graph::clearEdges() {
+    edge_list.clear();
+    adjacency_built = false;
+    std::fill(adjacency_masks.begin(), adjacency_masks.end(), 0);
+    degree_at_least_1 = 0;
+    degree_at_least_2 = 0;
+    num_edges = 0;
+}
+
+// Counting sort of the edge list into the out-runs by source and the in-runs by target
+void Graph::buildAdjacency() const {
+    if (adjacency_built) return;
+    const int numVertices = label_of_index.size();
+    out_offsets.assign(numVertices + 1, 0);
+    in_offsets.assign(numVertices + 1, 0);
+    for (const Edge& edge : edge_list) {
+        out_offsets[indexOf(edge.start) + 1]++;
+        in_offsets[indexOf(edge.end) + 1]++;
+    }
+    for (int index = 0; index < numVertices; ++index) {
+        out_offsets[index + 1] += out_offsets[index];
+        in_offsets[index + 1] += in_offsets[index];
+    }
+
+    out_sources.resize(num_edges);
+    out_targets.resize(num_edges);
+    out_positions.resize(num_edges);
+    in_sources.resize(num_edges);
+    in_positions.resize(num_edges);
+    std::vector<int> out_slot(out_offsets.begin(), out_offsets.end() - 1);
+    std::vector<int> in_slot(in_offsets.begin(), in_offsets.end() - 1);
+    for (const Edge& edge : edge_list) {
+        const int out_k = out_slot[indexOf(edge.start)]++;
+        out_sources[out_k] = edge.start;
+        out_targets[out_k] = edge.end;
+        out_positions[out_k] = edge.position;
+        const int in_k = in_slot[indexOf(edge.end)]++;
+        in_sources[in_k] = edge.start;
+        in_positions[in_k] = edge.position;
+    }
+    adjacency_built = true;
+}
+
+int Graph::degreeAt(int index) const {
+    buildAdjacency();
+    return (out_offsets[index + 1] - out_offsets[index]) + (in_offsets[index + 1] - in_offsets[index]);
+}
 
 void Graph::addEdge(int start, int end, int position){
-    edges[start].push_back(std::make_pair(end, position));
+    const int s = registerVertex(start);
+    const int e = registerVertex(end);
+
+    edge_list.push_back({start, end, position});
+    adjacency_built = false;
+
+    if (s < kMaxBitsetVertices && e < kMaxBitsetVertices) {
+        const uint64_t s_bit = uint64_t(1) << s;
+        const uint64_t e_bit = uint64_t(1) << e;
+        adjacency_masks[s] |= e_bit;
+        adjacency_masks[e] |= s_bit;
+        // Saturating 2-bit counters, one bit slice per mask; a self-loop counts twice
+        degree_at_least_2 |= degree_at_least_1 & s_bit;
+        degree_at_least_1 |= s_bit;
+        degree_at_least_2 |= degree_at_least_1 & e_bit;
+        degree_at_least_1 |= e_bit;
+    }
+
     num_edges++;
 }
 
-std::vector<Edge> Graph::getAllEdges() const {
-    std::vector<Edge> allEdges;
-    for (const auto& vertex : edges) {
-        for (const auto& edge : vertex.second) {
-            allEdges.push_back({vertex.first, edge.first, edge.second});
-        }
+uint64_t Graph::activeVertexMask() const {
+    uint64_t mask = 0;
+    for (int vertex : vertices) {
+        mask |= uint64_t(1) << indexOf(vertex);
     }
-    return allEdges;
+    return mask;
 }
 
-const std::unordered_map<int, std::pair<int, int>> Graph::getEdgesByPosition() const{
-    std::unordered_map<int, std::pair<int, int>> edges_by_position;
-    for (const auto& out_vertex_to_edges: edges){
-        for (const auto& edge: out_vertex_to_edges.second){
-            edges_by_position[edge.second] = std::make_pair(out_vertex_to_edges.first, edge.first);
-        }
+// Closure of `seed` under adjacency, restricted to the vertices in `allowed`
+uint64_t Graph::reachableWithin(uint64_t seed, uint64_t allowed) const {
+    uint64_t reached = seed & allowed;
+    uint64_t frontier = reached;
+    while (frontier) {
+        const int index = __builtin_ctzll(frontier);
+        frontier &= frontier - 1;
+        const uint64_t fresh = adjacency_masks[index] & allowed & ~reached;
+        reached |= fresh;
+        frontier |= fresh;
+    }
+    return reached;
+}
+
+std::vector<Edge> Graph::getAllEdges() const {
+    buildAdjacency();
+    std::vector<Edge> allEdges;
+    allEdges.reserve(num_edges);
+    for (int k = 0; k < num_edges; ++k) {
+        allEdges.push_back({out_sources[k], out_targets[k], out_positions[k]});
     }
-    return edges_by_position;
+    return allEdges;
 }
 
 void Graph::retainVertices(const std::unordered_set<int>& activeVertices) {
     // Remove edges that are not incident to active vertices
-    for (auto it = edges.begin(); it != edges.end();) {
-        if (activeVertices.find(it->first) == activeVertices.end()) {
-            it = edges.erase(it);
-        } else {
-            for (auto edgeIt = it->second.begin(); edgeIt != it->second.end();) {
-                if (activeVertices.find(edgeIt->first) == activeVertices.end()) {
-                    edgeIt = it->second.erase(edgeIt);
-                } else {
-                    ++edgeIt;
-                }
-            }
-            ++it;
+    std::vector<Edge> kept;
+    kept.reserve(num_edges);
+    for (const Edge& edge : getAllEdges()) {
+        if (activeVertices.find(edge.start) != activeVertices.end() &&
+            activeVertices.find(edge.end) != activeVertices.end()) {
+            kept.push_back(edge);
         }
     }
+    if (static_cast<int>(kept.size()) == num_edges) return;
+    clearEdges();
+    for (const Edge& edge : kept) {
+        Graph::addEdge(edge.start, edge.end, edge.position);
+    }
 }
 
 void Graph::displayGraph() const {
-    for (const auto& vertex : edges) {
+    for (const auto& vertex : getEdges()) {
         std::cout << "Vertex " << vertex.first << " has edges to: ";
         for (const auto& edge : vertex.second) {
             std::cout << "(" << edge.first << ", position: " << edge.second << ") ";
@@ -68,56 +174,47 @@ void Graph::displayGraph() const {
     }
 }
 
-std::vector<std::pair<int, int>> Graph::getIncomingEdges(int vertex) const {
-    std::vector<std::pair<int, int>> incomingEdges = {};
-
-    for (const auto& edgeList : edges) {
-        int startVertex = edgeList.first;
-        for (const auto& edge: edgeList.second){
-            int endVertex = edge.first;
+IncomingEdgeRange Graph::getIncomingEdges(int vertex) const {
+    return IncomingEdgeRange(getNeighborVecsAtVertex(vertex).first, vertex);
+}
 
-            // Check if this edge is incoming to the given vertex
-            if (endVertex == vertex) {
-                incomingEdges.push_back({startVertex, endVertex});
-            }
-        }
-    }
+int Graph::getInDegree(int vertex) const {
+    buildAdjacency();
+    const int index = indexOf(vertex);
+    return index < 0 ? 0 : in_offsets[index + 1] - in_offsets[index];
+}
 
-    return incomingEdges;
+int Graph::getOutDegree(int vertex) const {
+    buildAdjacency();
+    const int index = indexOf(vertex);
+    return index < 0 ? 0 : out_offsets[index + 1] - out_offsets[index];
 }
 
 void Graph::addVertex(int vertex){
     vertices.push_back(vertex);
+    registerVertex(vertex);
 }
 
 void Graph::rememberOriginalVertex(int originalVertex, int newVertex) {
-    originalVertices[newVertex] = originalVertex;
+    original_of_index[registerVertex(newVertex)] = originalVertex;
 }
 
-const std::unordered_map<int, int>& Graph::getOriginalVertices() const {
-    return originalVertices;
+int Graph::getOriginalVertex(int vertex) const {
+    const int index = indexOf(vertex);
+    assert(index >= 0 && "unknown vertex");
+    return original_of_index[index];
 }
 
 bool Graph::hasMinimumDegree(int minDegree) const {
-    std::unordered_map<int, int> vertexDegree;
-
-    // Iterate over all edges in the graph
-    for (const auto& vertexEdges : edges) {
-        int startVertex = vertexEdges.first;
-
-        // Increase degree count for the start vertex
-        vertexDegree[startVertex] += vertexEdges.second.size();
-
-        // Increase degree count for the end vertices
-        for (const auto& edge : vertexEdges.second) {
-            int endVertex = edge.first;
-            vertexDegree[endVertex] += 1;
-        }
+    if (minDegree <= 1) return true;
+    if (minDegree == 2 && usesBitsets()) {
+        return (degree_at_least_1 & ~degree_at_least_2) == 0;
     }
 
-    // Check if all vertices have at least the minimum degree
-    for (const auto& degree : vertexDegree) {
-        if (degree.second < minDegree) {
+    // Only vertices that touch an edge are checked
+    for (size_t index = 0; index < label_of_index.size(); ++index) {
+        const int degree = degreeAt(index);
+        if (degree > 0 && degree < minDegree) {
             return false;
         }
     }
@@ -125,45 +222,43 @@ bool Graph::hasMinimumDegree(int minDegree) const {
     return true;
 }
 
-const std::pair<std::vector<int>, std::vector<int>> Graph::getNeighborVecsAtVertex(int vertex) const {
-    const auto& incoming_edges = getIncomingEdges(vertex); 
-    std::vector<std::pair<int, int>> outgoing_edges = {}; 
-    if (edges.find(vertex) != edges.end()){ 
-       outgoing_edges = edges.at(vertex); 
-    };
-    std::vector<int> incoming = {};
-    for (const auto& edge: incoming_edges){
-        incoming.push_back(edge.first);
+const std::pair<VertexRange, VertexRange> Graph::getNeighborVecsAtVertex(int vertex) const {
+    const int index = indexOf(vertex);
+    if (index < 0) {
+        return std::make_pair(VertexRange(nullptr, nullptr), VertexRange(nullptr, nullptr));
     }
-    std::vector<int> outgoing = {};
-    for (const auto& edge: outgoing_edges){
-        outgoing.push_back(edge.first);
-    }
-    const auto& neighbors_pair = std::make_pair(incoming, outgoing);
-    return neighbors_pair; 
+    buildAdjacency();
+    const int* in_data = in_sources.data();
+    const int* out_data = out_targets.data();
+    return std::make_pair(VertexRange(in_data + in_offsets[index], in_data + in_offsets[index + 1]),
+                          VertexRange(out_data + out_offsets[index], out_data + out_offsets[index + 1]));
 }
 
 Graph Graph::getInducedSubgraph(const std::vector<int>& subsetVertices) const {
-    std::unordered_set<int> vertexSet(subsetVertices.begin(), subsetVertices.end());
+    std::vector<char> inSubset(label_of_index.size(), 0);
+    for (int vertex : subsetVertices) {
+        const int index = indexOf(vertex);
+        if (index >= 0) inSubset[index] = 1;
+    }
     Graph subgraph(subsetVertices);
 
+    buildAdjacency();
     for (int vertex : subsetVertices) {
-        if (edges.find(vertex) != edges.end()) {
-            for (const auto& edge : edges.at(vertex)) {
-                int neighbor = edge.first;
-                int position = edge.second;
-                if (vertexSet.find(neighbor) != vertexSet.end()) {
-                    subgraph.addEdge(vertex, neighbor, position);
-                }
+        const int index = indexOf(vertex);
+        if (index < 0) continue;
+        for (int k = out_offsets[index]; k < out_offsets[index + 1]; ++k) {
+            const int neighbor = out_targets[k];
+            if (inSubset[indexOf(neighbor)]) {
+                subgraph.addEdge(vertex, neighbor, out_positions[k]);
             }
         }
     }
 
     // Preserve original vertices information
     for (int vertex : subsetVertices) {
-        auto it = originalVertices.find(vertex);
-        if (it != originalVertices.end()) {
-            subgraph.rememberOriginalVertex(it->second, vertex);
+        const int index = indexOf(vertex);
+        if (index >= 0) {
+            subgraph.rememberOriginalVertex(original_of_index[index], vertex);
         }
     }
 
@@ -173,138 +268,159 @@ Graph Graph::getInducedSubgraph(const std::vector<int>& subsetVertices) const {
 bool Graph::isConnected() const {
     if (vertices.empty()) return true; // An empty graph is considered connected
 
-    std::unordered_set<int> visited;
-    std::list<int> queue;
-    int startVertex = vertices.front();
-
-    // Start BFS or DFS from the first vertex
-    queue.push_back(startVertex);
-    visited.insert(startVertex);
-
-    while (!queue.empty()) {
-        int vertex = queue.front();
-        queue.pop_front();
+    if (usesBitsets()) {
+        const uint64_t active = activeVertexMask();
+        const uint64_t start = uint64_t(1) << indexOf(vertices.front());
+        return reachableWithin(start, active) == active;
+    }
 
-        const auto& neighbors = getNeighborsAtVertex(vertex);
-        for (const int neighbor : neighbors) {
-            if (visited.find(neighbor) == visited.end()) {
-                visited.insert(neighbor);
-                queue.push_back(neighbor);
+    buildAdjacency();
+    std::vector<char> visited(label_of_index.size(), 0);
+    std::vector<int> queue;
+    queue.reserve(label_of_index.size());
+    const int startIndex = indexOf(vertices.front());
+
+    // Start BFS from the first vertex
+    queue.push_back(startIndex);
+    visited[startIndex] = 1;
+
+    for (size_t head = 0; head < queue.size(); ++head) {
+        const int index = queue[head];
+        auto visit = [&](int neighbor) {
+            const int neighborIndex = indexOf(neighbor);
+            if (!visited[neighborIndex]) {
+                visited[neighborIndex] = 1;
+                queue.push_back(neighborIndex);
             }
-        }
+        };
+        for (int k = out_offsets[index]; k < out_offsets[index + 1]; ++k) visit(out_targets[k]);
+        for (int k = in_offsets[index]; k < in_offsets[index + 1]; ++k) visit(in_sources[k]);
     }
 
     // Check if all vertices were visited
-    return visited.size() == vertices.size();
+    return queue.size() == vertices.size();
 }
 
-const std::vector<int> Graph::getNeighborsAtVertex(int vertex) const{
+NeighborRange Graph::getNeighborsAtVertex(int vertex) const{
     const auto& incoming_outgoing = getNeighborVecsAtVertex(vertex);
-    std::vector<int> neighbor_vec;
-    neighbor_vec.reserve(incoming_outgoing.first.size() + incoming_outgoing.second.size());
-    neighbor_vec.insert(neighbor_vec.end(), incoming_outgoing.second.begin(), incoming_outgoing.second.end());
-    neighbor_vec.insert(neighbor_vec.end(), incoming_outgoing.first.begin(), incoming_outgoing.first.end());
-    return neighbor_vec;
+    return NeighborRange(incoming_outgoing.second, incoming_outgoing.first);
 }
 
-void Graph::internalDFS(int vertex, std::unordered_map<int, bool>& visited,
-                        std::unordered_map<int, int>& disc, std::unordered_map<int, int>& low,
-                        std::unordered_map<int, int>& parentMap, std::unordered_set<int>& articulationPoints,
-                        int& time, bool& isBiconnected) const {
+// Tarjan's articulation point search over dense indices; parent -1 marks a DFS root. Indices
+// are never negative, so unlike a vertex label the marker cannot be mistaken for a parent.
+void Graph::internalDFS(int index, std::vector<int>& disc, std::vector<int>& low,
+                        std::vector<int>& parent, bool& hasArticulationPoint, int& time) const {
     int children = 0;
-    visited[vertex] = true;
-    disc[vertex] = low[vertex] = ++time;
-    
-    for (const int& neighbor : getNeighborsAtVertex(vertex)) {
-        if (!visited[neighbor]) {
+    disc[index] = low[index] = ++time;
+
+    auto visit = [&](int neighbor) {
+        const int neighborIndex = indexOf(neighbor);
+        if (disc[neighborIndex] == 0) {
             children++;
-            parentMap[neighbor] = vertex;
-            internalDFS(neighbor, visited, disc, low, parentMap, articulationPoints, time, isBiconnected);
+            parent[neighborIndex] = index;
+            internalDFS(neighborIndex, disc, low, parent, hasArticulationPoint, time);
 
-            low[vertex] = std::min(low[vertex], low[neighbor]);
+            low[index] = std::min(low[index], low[neighborIndex]);
 
-            if (parentMap[vertex] == -1 && children > 1) {
-                articulationPoints.insert(vertex);
+            if (parent[index] == -1 && children > 1) {
+                hasArticulationPoint = true;
             }
 
-            if (parentMap[vertex] != -1 && low[neighbor] >= disc[vertex]) {
-                articulationPoints.insert(vertex);
+            if (parent[index] != -1 && low[neighborIndex] >= disc[index]) {
+                hasArticulationPoint = true;
             }
-        } else if (neighbor != parentMap[vertex]) {
-            low[vertex] = std::min(low[vertex], disc[neighbor]);
+        } else if (neighborIndex != parent[index]) {
+            low[index] = std::min(low[index], disc[neighborIndex]);
         }
-    }
+    };
+    for (int k = out_offsets[index]; k < out_offsets[index + 1]; ++k) visit(out_targets[k]);
+    for (int k = in_offsets[index]; k < in_offsets[index + 1]; ++k) visit(in_sources[k]);
 }
 
 bool Graph::isBiconnected() const {
     if (!isConnected()) return false;
 
-    std::unordered_map<int, bool> visited;
-    std::unordered_map<int, int> disc;
-    std::unordered_map<int, int> low;
-    std::unordered_map<int, int> parentMap;
-    std::unordered_set<int> articulationPoints;
-    int time = 0;
-    bool isBiconnected = true;
-
-    for (int vertex : vertices) {
-        visited[vertex] = false;
-        parentMap[vertex] = -1;
+    // Small graphs: remove each vertex in turn and recheck connectivity of the rest
+    if (usesBitsets()) {
+        const uint64_t active = activeVertexMask();
+        if (__builtin_popcountll(active) <= 2) return true;
+        for (uint64_t remaining = active; remaining; remaining &= remaining - 1) {
+            const uint64_t removed = remaining & (~remaining + 1);
+            const uint64_t rest = active & ~removed;
+            const uint64_t start = rest & (~rest + 1);
+            if (reachableWithin(start, rest) != rest) return false;
+        }
+        return true;
     }
 
+    // disc == 0 marks an unvisited vertex
+    buildAdjacency();
+    std::vector<int> disc(label_of_index.size(), 0);
+    std::vector<int> low(label_of_index.size(), 0);
+    std::vector<int> parent(label_of_index.size(), -1);
+    bool hasArticulationPoint = false;
+    int time = 0;
+
     for (int vertex : vertices) {
-        if (!visited[vertex]) {
-            internalDFS(vertex, visited, disc, low, parentMap, articulationPoints, time, isBiconnected);
+        const int index = indexOf(vertex);
+        if (disc[index] == 0) {
+            internalDFS(index, disc, low, parent, hasArticulationPoint, time);
         }
     }
 
-    return articulationPoints.empty();
+    return !hasArticulationPoint;
 }
 
-struct PairHash {
-    template <typename T1, typename T2>
-    std::size_t operator()(const std::pair<T1, T2>& p) const {
-        auto hash1 = std::hash<T1>{}(p.first);
-        auto hash2 = std::hash<T2>{}(p.second);
-        return hash1 ^ (hash2 << 1); // Shift and combine
+std::vector<Graph> Graph::getConnectedComponents() const {
+    if (usesBitsets()) {
+        std::vector<Graph> components;
+        std::vector<int> componentVertices;
+        uint64_t unvisited = activeVertexMask();
+        while (unvisited) {
+            const uint64_t component = reachableWithin(unvisited & (~unvisited + 1), unvisited);
+            unvisited &= ~component;
+            componentVertices.clear();
+            for (uint64_t bits = component; bits; bits &= bits - 1) {
+                componentVertices.push_back(label_of_index[__builtin_ctzll(bits)]);
+            }
+            components.push_back(getInducedSubgraph(componentVertices));
+        }
+        return components;
     }
-};
 
-std::vector<Graph> Graph::getConnectedComponents() const {
-    std::unordered_set<int> visited;
+    buildAdjacency();
+    std::vector<char> visited(label_of_index.size(), 0);
     std::vector<Graph> components;
+    std::vector<int> queue;
+    queue.reserve(label_of_index.size());
 
-    auto processVertexForComponents = [&](int vertex) {
+    auto processVertexForComponents = [&](int startIndex) {
         std::vector<int> componentVertices;
-        std::list<int> queue;
-        queue.push_back(vertex);
-        visited.insert(vertex);
-        while (!queue.empty()) {
-            int currentVertex = queue.front();
-            componentVertices.push_back(currentVertex);
-            queue.pop_front();
-            const auto& incoming_outgoing = getNeighborVecsAtVertex(currentVertex);
-            auto processNeighbor = [&] (int neighbor, bool incoming){
-                if (visited.find(neighbor) == visited.end()) { 
-                    queue.push_back(neighbor);
-                    visited.insert(neighbor);
+        queue.clear();
+        queue.push_back(startIndex);
+        visited[startIndex] = 1;
+        for (size_t head = 0; head < queue.size(); ++head) {
+            const int currentIndex = queue[head];
+            componentVertices.push_back(label_of_index[currentIndex]);
+            auto processNeighbor = [&] (int neighbor){
+                const int neighborIndex = indexOf(neighbor);
+                if (!visited[neighborIndex]) {
+                    queue.push_back(neighborIndex);
+                    visited[neighborIndex] = 1;
                 }
             };
-            for (const auto& nbr: incoming_outgoing.first){
-                processNeighbor(nbr, true);
-            }
-            for (const auto& nbr: incoming_outgoing.second){
-                processNeighbor(nbr, false);
-            }
+            for (int k = in_offsets[currentIndex]; k < in_offsets[currentIndex + 1]; ++k) processNeighbor(in_sources[k]);
+            for (int k = out_offsets[currentIndex]; k < out_offsets[currentIndex + 1]; ++k) processNeighbor(out_targets[k]);
         }
-        
+
         Graph componentGraph = getInducedSubgraph(componentVertices);
         components.push_back(componentGraph);
     };
 
     for (int vertex : vertices) {
-        if (visited.find(vertex) == visited.end()) {
-            processVertexForComponents(vertex);
+        const int index = indexOf(vertex);
+        if (!visited[index]) {
+            processVertexForComponents(index);
         }
     }
 
@@ -367,7 +483,7 @@ void Graph::printAdjacencyMatrix() const {
 
     // Fill the mappings for new vertices to original vertices with unique identifiers
     for (const auto& vertex : vertices) {
-        int originalVertex = originalVertices.at(vertex);
+        int originalVertex = getOriginalVertex(vertex);
         
         // Create unique label for each vertex appearance
         int label = originalVertexCount[originalVertex]++; // Increment count for that original vertex
@@ -424,23 +540,10 @@ void Graph::printAdjacencyMatrix() const {
 }
 
 void Graph::removeIsolatedVertices() {
-    // Set to store vertices that are connected via any edge
-    std::unordered_set<int> connectedVertices;
-    
-    // Identify all connected vertices
-    for(const auto& [vertex, adj] : edges){
-        if(!adj.empty()){
-            connectedVertices.insert(vertex);
-            for(const auto& [neighbor, pos] : adj){
-                connectedVertices.insert(neighbor);
-            }
-        }
-    }
-    
     // Collect non-isolated vertices
     std::vector<int> nonIsolatedVertices;
     for(const auto& vertex : vertices){
-        if(connectedVertices.find(vertex) != connectedVertices.end()){
+        if(degreeAt(indexOf(vertex)) > 0){
             nonIsolatedVertices.push_back(vertex);
         }
     }
@@ -448,3 +551,44 @@ void Graph::removeIsolatedVertices() {
     // Update the vertices list
     vertices = nonIsolatedVertices;
 }
+
+EdgeMapView::value_type EdgeMapView::iterator::operator*() const {
+    const int first = graph->out_offsets[index];
+    const int count = graph->out_offsets[index + 1] - first;
+    return {graph->label_of_index[index], AdjacencyRange(graph->out_targets.data() + first, graph->out_positions.data() + first, count)};
+}
+
+void EdgeMapView::iterator::skipEmpty() {
+    const int size = graph->label_of_index.size();
+    while (index < size && graph->out_offsets[index + 1] == graph->out_offsets[index]) {
+        ++index;
+    }
+}
+
+EdgeMapView::iterator EdgeMapView::end() const {
+    return iterator(graph, graph->label_of_index.size());
+}
+
+std::pair<int, std::pair<int, int>> EdgesByPositionView::iterator::operator*() const {
+    return std::make_pair(graph->out_positions[slot], std::make_pair(graph->out_sources[slot], graph->out_targets[slot]));
+}
+
+EdgesByPositionView::iterator EdgesByPositionView::end() const {
+    return iterator(graph, graph->num_edges);
+}
+
+size_t EdgesByPositionView::size() const {
+    return graph->num_edges;
+}
+
+std::pair<int, int> OriginalVerticesView::iterator::operator*() const {
+    return std::make_pair(graph->label_of_index[index], graph->original_of_index[index]);
+}
+
+OriginalVerticesView::iterator OriginalVerticesView::end() const {
+    return iterator(graph, graph->label_of_index.size());
+}
+
+size_t OriginalVerticesView::size() const {
+    return graph->label_of_index.size();
+}
@@ -7,6 +7,8 @@
 #include <list>
 #include <utility>
 #include <functional>
+#include <cstddef>
+#include <cstdint>
 
 struct Edge {
     int start;
@@ -14,22 +16,208 @@ struct Edge {
     int position;
 };
 
+// Contiguous run of vertex labels, e.g. the sources of the edges entering a vertex
+class VertexRange {
+public:
+    VertexRange(const int* begin_, const int* end_) : first(begin_), last(end_) {}
+    const int* begin() const { return first; }
+    const int* end() const { return last; }
+    size_t size() const { return last - first; }
+    bool empty() const { return first == last; }
+
+private:
+    const int* first;
+    const int* last;
+};
+
+// Out-edges of one vertex, iterated as (target, position) pairs
+class AdjacencyRange {
+public:
+    class iterator {
+    public:
+        iterator(const int* target_, const int* position_) : target(target_), position(position_) {}
+        std::pair<int, int> operator*() const { return std::make_pair(*target, *position); }
+        iterator& operator++() { ++target; ++position; return *this; }
+        bool operator==(const iterator& other) const { return target == other.target; }
+        bool operator!=(const iterator& other) const { return target != other.target; }
+    private:
+        const int* target;
+        const int* position;
+    };
+
+    AdjacencyRange(const int* targets_, const int* positions_, size_t count_) : targets(targets_), positions(positions_), count(count_) {}
+    iterator begin() const { return iterator(targets, positions); }
+    iterator end() const { return iterator(targets + count, positions + count); }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+private:
+    const int* targets;
+    const int* positions;
+    size_t count;
+};
+
+// Outgoing targets followed by incoming sources of one vertex, without copying either run
+class NeighborRange {
+public:
+    class iterator {
+    public:
+        iterator(const int* current_, const int* first_end_, const int* second_begin_)
+            : current(current_), first_end(first_end_), second_begin(second_begin_) { hop(); }
+        int operator*() const { return *current; }
+        iterator& operator++() { ++current; hop(); return *this; }
+        bool operator==(const iterator& other) const { return current == other.current; }
+        bool operator!=(const iterator& other) const { return current != other.current; }
+    private:
+        void hop() { if (current == first_end) current = second_begin; }
+        const int* current;
+        const int* first_end;
+        const int* second_begin;
+    };
+
+    NeighborRange(VertexRange outgoing_, VertexRange incoming_) : outgoing(outgoing_), incoming(incoming_) {}
+    iterator begin() const { return iterator(outgoing.begin(), outgoing.end(), incoming.begin()); }
+    iterator end() const { return iterator(incoming.end(), outgoing.end(), incoming.end()); }
+    size_t size() const { return outgoing.size() + incoming.size(); }
+    bool empty() const { return size() == 0; }
+
+private:
+    VertexRange outgoing;
+    VertexRange incoming;
+};
+
+// Edges entering one vertex, iterated as (start, end) pairs
+class IncomingEdgeRange {
+public:
+    class iterator {
+    public:
+        iterator(const int* source_, int vertex_) : source(source_), vertex(vertex_) {}
+        std::pair<int, int> operator*() const { return std::make_pair(*source, vertex); }
+        iterator& operator++() { ++source; return *this; }
+        bool operator==(const iterator& other) const { return source == other.source; }
+        bool operator!=(const iterator& other) const { return source != other.source; }
+    private:
+        const int* source;
+        int vertex;
+    };
+
+    IncomingEdgeRange(VertexRange sources_, int vertex_) : sources(sources_), vertex(vertex_) {}
+    iterator begin() const { return iterator(sources.begin(), vertex); }
+    iterator end() const { return iterator(sources.end(), vertex); }
+    size_t size() const { return sources.size(); }
+    bool empty() const { return sources.empty(); }
+
+private:
+    VertexRange sources;
+    int vertex;
+};
+
+class Graph;
+
+// View over the out-adjacency of every vertex that has out-edges, iterated as
+// {first = vertex, second = AdjacencyRange} (same shape as the old unordered_map)
+class EdgeMapView {
+public:
+    struct value_type {
+        int first;
+        AdjacencyRange second;
+    };
+    class iterator {
+    public:
+        iterator(const Graph* graph_, int index_) : graph(graph_), index(index_) { skipEmpty(); }
+        value_type operator*() const;
+        iterator& operator++() { ++index; skipEmpty(); return *this; }
+        bool operator==(const iterator& other) const { return index == other.index; }
+        bool operator!=(const iterator& other) const { return index != other.index; }
+    private:
+        void skipEmpty();
+        const Graph* graph;
+        int index;
+    };
+
+    explicit EdgeMapView(const Graph* graph_) : graph(graph_) {}
+    iterator begin() const { return iterator(graph, 0); }
+    iterator end() const;
+
+private:
+    const Graph* graph;
+};
+
+// View over all edges keyed by position, iterated as (position, (start, end)) pairs
+class EdgesByPositionView {
+public:
+    class iterator {
+    public:
+        iterator(const Graph* graph_, int slot_) : graph(graph_), slot(slot_) {}
+        std::pair<int, std::pair<int, int>> operator*() const;
+        iterator& operator++() { ++slot; return *this; }
+        bool operator==(const iterator& other) const { return slot == other.slot; }
+        bool operator!=(const iterator& other) const { return slot != other.slot; }
+    private:
+        const Graph* graph;
+        int slot;
+    };
+
+    explicit EdgesByPositionView(const Graph* graph_) : graph(graph_) {}
+    iterator begin() const { return iterator(graph, 0); }
+    iterator end() const;
+    size_t size() const;
+
+private:
+    const Graph* graph;
+};
+
+// View over (vertex, original vertex) pairs of every vertex the graph knows about
+class OriginalVerticesView {
+public:
+    class iterator {
+    public:
+        iterator(const Graph* graph_, int index_) : graph(graph_), index(index_) {}
+        std::pair<int, int> operator*() const;
+        iterator& operator++() { ++index; return *this; }
+        bool operator==(const iterator& other) const { return index == other.index; }
+        bool operator!=(const iterator& other) const { return index != other.index; }
+    private:
+        const Graph* graph;
+        int index;
+    };
+
+    explicit OriginalVerticesView(const Graph* graph_) : graph(graph_) {}
+    iterator begin() const { return iterator(graph, 0); }
+    iterator end() const;
+    size_t size() const;
+
+private:
+    const Graph* graph;
+};
+
+// Vertices carry small signed labels (+-1..+-r for core graphs, 0..s-1 for unfolded ones).
+// Internally every label is remapped to a dense index, and edges are stored in CSR form:
+// the out-edges of dense vertex v occupy [out_offsets[v], out_offsets[v+1]) of the
+// out_* arrays, and the in-edges occupy [in_offsets[v], in_offsets[v+1]) of the in_* arrays.
+// Edges are appended to a list as they are added and the CSR arrays are built from it on the
+// first query after a change, so that query writes to the graph: a graph must not be first
+// read from several threads at once.
 class Graph {
 public:
     Graph(const std::vector<int> vertices_);
 
     virtual void addEdge(int start, int end, int position);
     std::vector<Edge> getAllEdges() const;
-    const std::vector<int> getVertices() const { return vertices; }
+    int getNumEdges() const { return num_edges; }
+    const std::vector<int>& getVertices() const { return vertices; }
     void retainVertices(const std::unordered_set<int>& activeVertices);
-    const std::unordered_map<int, std::vector<std::pair<int, int>>>& getEdges() const {return edges;}
-    const std::unordered_map<int, std::pair<int, int>> getEdgesByPosition() const;
+    EdgeMapView getEdges() const { buildAdjacency(); return EdgeMapView(this); }
+    EdgesByPositionView getEdgesByPosition() const { buildAdjacency(); return EdgesByPositionView(this); }
     void displayGraph() const;
-    std::vector<std::pair<int, int>> getIncomingEdges(int vertex) const;
-    const std::pair<std::vector<int>, std::vector<int>> getNeighborVecsAtVertex(int vertex) const; //incoming_vec, outgoing_vec
-    const std::vector<int> getNeighborsAtVertex(int vertex) const;
+    IncomingEdgeRange getIncomingEdges(int vertex) const;
+    const std::pair<VertexRange, VertexRange> getNeighborVecsAtVertex(int vertex) const; //incoming_vec, outgoing_vec
+    NeighborRange getNeighborsAtVertex(int vertex) const; // outgoing, then incoming
+    int getInDegree(int vertex) const;
+    int getOutDegree(int vertex) const;
     void addVertex(int vertex);
-    const std::unordered_map<int, int>& getOriginalVertices() const;
+    OriginalVerticesView getOriginalVertices() const { return OriginalVerticesView(this); }
+    int getOriginalVertex(int vertex) const;
     void rememberOriginalVertex(int originalVertex, int newVertex);
     bool hasMinimumDegree(int minDegree) const;
     bool isConnected() const;
@@ -42,12 +230,49 @@ public:
 protected:
     int num_edges = 0;
     std::vector<int> vertices;
-    std::unordered_map<int, std::vector<std::pair<int, int> > > edges;
-    std::unordered_map<int, int> originalVertices;
-    void internalDFS(int vertex, std::unordered_map<int, bool>& visited,
-                        std::unordered_map<int, int>& disc, std::unordered_map<int, int>& low,
-                        std::unordered_map<int, int>& parentMap, std::unordered_set<int>& articulationPoints,
-                        int& time, bool& isBiconnected) const;
+
+    // Label <-> dense index maps; index_of_label is offset by label_offset, -1 if unknown
+    int label_offset = 0;
+    std::vector<int> index_of_label;
+    std::vector<int> label_of_index;
+    std::vector<int> original_of_index;
+
+    // Edges in the order they were added
+    std::vector<Edge> edge_list;
+
+    // CSR adjacency, indexed by dense vertex index; sources/targets hold vertex labels. Within
+    // a vertex, edges keep the order they were added in.
+    mutable bool adjacency_built = true;
+    mutable std::vector<int> out_offsets = {0};
+    mutable std::vector<int> out_sources;
+    mutable std::vector<int> out_targets;
+    mutable std::vector<int> out_positions;
+    mutable std::vector<int> in_offsets = {0};
+    mutable std::vector<int> in_sources;
+    mutable std::vector<int> in_positions;
+
+    // Bitset kernel: one undirected neighbor mask per dense vertex plus bit-sliced
+    // "degree >= 1" / "degree >= 2" masks. Only valid while there are at most 64 vertices;
+    // larger graphs fall back to the CSR traversals.
+    static const int kMaxBitsetVertices = 64;
+    std::vector<uint64_t> adjacency_masks;
+    uint64_t degree_at_least_1 = 0;
+    uint64_t degree_at_least_2 = 0;
+    bool usesBitsets() const { return label_of_index.size() <= static_cast<size_t>(kMaxBitsetVertices); }
+    uint64_t activeVertexMask() const;
+    uint64_t reachableWithin(uint64_t seed, uint64_t allowed) const;
+
+    int indexOf(int vertex) const;
+    int registerVertex(int vertex);
+    void clearEdges();
+    void buildAdjacency() const;
+    int degreeAt(int index) const;
+    void internalDFS(int index, std::vector<int>& disc, std::vector<int>& low,
+                        std::vector<int>& parent, bool& hasArticulationPoint, int& time) const;
+
+    friend class EdgeMapView;
+    friend class EdgesByPositionView;
+    friend class OriginalVerticesView;
 };
 
 #endif // GRAPH_H
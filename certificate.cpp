@@ -0,0 +1,324 @@
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <sstream>
+#include <cmath>
+#include <algorithm>
+#include <memory>
+#include "certificate.h"
+#include "CoreWhiteheadGraph.h"
+#include "stable_invariants_types.h"
+#include "linear_program_construction.h"
+
+// Text format, one record per line:
+//   stable-invariant-certificate 1
+//   problem <type> <r> <m>
+//   word <n> <letters...>
+//   value <p/q>
+//   graphs <count>
+//   <weight> <blocks> { <size> <signed positions...> }   (one line per graph)
+//   degree <dual>
+//   duals <count>
+//   <size> <signed positions...> <dual>                 (one line per gluing key)
+//   end
+namespace {
+    const char* kCertificateHeader = "stable-invariant-certificate";
+    const int kCertificateVersion = 1;
+
+    bool parseRational(const std::string& text, Exact::Rational& value) {
+        const size_t slash = text.find('/');
+        try {
+            size_t used = 0;
+            const long long numerator = std::stoll(text.substr(0, slash), &used);
+            if (used != (slash == std::string::npos ? text.size() : slash)) return false;
+            long long denominator = 1;
+            if (slash != std::string::npos) {
+                denominator = std::stoll(text.substr(slash + 1), &used);
+                if (used != text.size() - slash - 1 || denominator <= 0) return false;
+            }
+            value = Exact::Rational(static_cast<__int128>(numerator), static_cast<__int128>(denominator));
+            return true;
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+
+    bool readRational(std::istream& in, Exact::Rational& value) {
+        std::string text;
+        return static_cast<bool>(in >> text) && parseRational(text, value);
+    }
+
+    bool expect(std::istream& in, const std::string& word) {
+        std::string text;
+        return static_cast<bool>(in >> text) && text == word;
+    }
+
+    struct GluingKeyHash {
+        std::size_t operator()(const EquationConstruction::GluingKey& key) const { return key.hash(); }
+    };
+    typedef std::unordered_map<EquationConstruction::GluingKey, Exact::Rational, GluingKeyHash> KeyValues;
+
+    EquationConstruction::GluingKey keyOfPositions(const std::vector<int>& positions) {
+        EquationConstruction::GluingKey key;
+        for (int position : positions) {
+            if (position > 0) key.addOutgoing(position);
+            else key.addIncoming(-position);
+        }
+        return key;
+    }
+
+    Exact::Rational valueOr0(const KeyValues& values, const EquationConstruction::GluingKey& key) {
+        auto it = values.find(key);
+        return it == values.end() ? Exact::Rational() : it->second;
+    }
+
+    // What one column contributes: its objective coefficient, gluing keys and degree-row flag
+    struct ColumnData {
+        Exact::Rational objective;
+        std::vector<EquationConstruction::GluingKey> keys;
+        bool first_letter = false;
+    };
+
+    ColumnData columnOf(const WhiteheadGraph& graph) {
+        ColumnData column;
+        column.objective = Exact::Rational(static_cast<int64_t>(std::llround(EquationConstruction::getObjectiveCoefficient(graph))));
+        column.keys = EquationConstruction::getGluingKeys(graph);
+        column.first_letter = EquationConstruction::hasFirstLetterEdge(graph);
+        return column;
+    }
+
+    // Price of a column under the duals: degree dual if it has the first-letter edge, plus the
+    // dual of each of its keys minus the dual of the key's opposite
+    Exact::Rational priceOf(const ColumnData& column, const KeyValues& duals, const Exact::Rational& degree_dual, int n) {
+        Exact::Rational price = column.first_letter ? degree_dual : Exact::Rational();
+        for (const auto& key : column.keys) {
+            price += valueOr0(duals, key) - valueOr0(duals, key.opposite(n));
+        }
+        return price;
+    }
+
+    // Rebuilds a certificate graph and checks that it is a column of the LP: its blocks split
+    // the half-edges of a valid subgraph of the core graph, each block sits at one original
+    // vertex and has at least two half-edges, and the unfolding itself is valid
+    bool buildColumnGraph(const CertificateGraph& entry, const OptimalityCertificate& certificate, const CoreWhiteheadGraph& core,
+                          StableInvariant& invariant, std::unique_ptr<WhiteheadGraph>& graph, std::string& error) {
+        const std::vector<int>& word = certificate.word;
+        const int n = word.size();
+        std::vector<int> tail_block(n + 1, -1), head_block(n + 1, -1);
+        std::vector<int> original_of_block;
+        for (size_t b = 0; b < entry.blocks.size(); ++b) {
+            const auto& block = entry.blocks[b];
+            if (block.size() < 2) { error = "a block has fewer than two half-edges"; return false; }
+            int original = 0;
+            for (int half_edge : block) {
+                const int position = std::abs(half_edge);
+                if (position < 1 || position > n) { error = "half-edge position out of range"; return false; }
+                const int vertex = half_edge > 0 ? -word[position - 1] : word[position % n];
+                if (original != 0 && vertex != original) { error = "a block mixes original vertices"; return false; }
+                original = vertex;
+                int& slot = half_edge > 0 ? tail_block[position] : head_block[position];
+                if (slot >= 0) { error = "a half-edge appears twice"; return false; }
+                slot = b;
+            }
+            original_of_block.push_back(original);
+        }
+
+        std::vector<Edge> subset;
+        for (const Edge& edge : core.getAllEdges()) {
+            const int p = edge.position;
+            if ((tail_block[p] < 0) != (head_block[p] < 0)) { error = "an edge has only one half-edge"; return false; }
+            if (tail_block[p] >= 0) subset.push_back(edge);
+        }
+        WhiteheadGraph subgraph = VariableConstruction::buildSubgraph(core, subset);
+        subgraph.removeIsolatedVertices();
+        if (!invariant.isValidWHGraphForInvariant(Graph(subgraph))) { error = "the underlying subgraph is not valid"; return false; }
+
+        if (certificate.problem_type == PROBLEM_TYPE::SPI_M) {
+            // Columns are the subgraphs themselves: one block per original vertex
+            std::vector<int> sorted = original_of_block;
+            std::sort(sorted.begin(), sorted.end());
+            if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end()) { error = "an original vertex is split"; return false; }
+            graph = std::make_unique<WhiteheadGraph>(subgraph);
+        } else {
+            graph = std::make_unique<WhiteheadGraph>(0, true);
+            for (size_t b = 0; b < original_of_block.size(); ++b) {
+                graph->addVertex(b);
+                graph->rememberOriginalVertex(original_of_block[b], b);
+            }
+            for (const Edge& edge : subset) {
+                graph->addEdge(tail_block[edge.position], head_block[edge.position], edge.position);
+            }
+        }
+        if (!VariableConstruction::isValidUnfolding(*graph, invariant)) { error = "the graph is not a valid unfolding"; return false; }
+        return true;
+    }
+}
+
+void writeCertificate(std::ostream& out, const OptimalityCertificate& certificate) {
+    out << kCertificateHeader << " " << kCertificateVersion << "\n";
+    out << "problem " << static_cast<int>(certificate.problem_type) << " " << certificate.r << " " << certificate.m << "\n";
+    out << "word " << certificate.word.size();
+    for (int letter : certificate.word) out << " " << letter;
+    out << "\nvalue " << certificate.value.toString() << "\n";
+    out << "graphs " << certificate.graphs.size() << "\n";
+    for (const auto& graph : certificate.graphs) {
+        out << graph.weight.toString() << " " << graph.blocks.size();
+        for (const auto& block : graph.blocks) {
+            out << "  " << block.size();
+            for (int half_edge : block) out << " " << half_edge;
+        }
+        out << "\n";
+    }
+    out << "degree " << certificate.degree_dual.toString() << "\n";
+    out << "duals " << certificate.gluing_duals.size() << "\n";
+    for (const auto& dual : certificate.gluing_duals) {
+        out << dual.key.size();
+        for (int position : dual.key) out << " " << position;
+        out << " " << dual.value.toString() << "\n";
+    }
+    out << "end\n";
+}
+
+bool readCertificate(std::istream& in, OptimalityCertificate& certificate, std::string& error) {
+    certificate = OptimalityCertificate();
+    int version = 0, type = 0;
+    size_t count = 0;
+    if (!expect(in, kCertificateHeader) || !(in >> version) || version != kCertificateVersion) {
+        error = "not a version " + std::to_string(kCertificateVersion) + " certificate";
+        return false;
+    }
+    if (!expect(in, "problem") || !(in >> type >> certificate.r >> certificate.m)) { error = "bad problem line"; return false; }
+    certificate.problem_type = PROBLEM_TYPE(type);
+    // Counts are bounded before anything is sized by them: the word by the longest word a gluing
+    // key holds, and a graph's blocks, a block and a dual key by the word's 2n signed positions.
+    // The numbers of graphs and duals have no such bound, so those entries are appended as read.
+    if (!expect(in, "word") || !(in >> count) || count > static_cast<size_t>(EquationConstruction::GluingKey::kMaxWordLength)) {
+        error = "bad word line";
+        return false;
+    }
+    const size_t max_positions = 2 * count;
+    certificate.word.resize(count);
+    for (auto& letter : certificate.word) {
+        if (!(in >> letter) || letter == 0 || std::abs(letter) > certificate.r) { error = "bad letter"; return false; }
+    }
+    if (!expect(in, "value") || !readRational(in, certificate.value)) { error = "bad value line"; return false; }
+    if (!expect(in, "graphs") || !(in >> count)) { error = "bad graphs line"; return false; }
+    for (size_t g = 0; g < count; ++g) {
+        CertificateGraph& graph = certificate.graphs.emplace_back();
+        size_t blocks = 0;
+        if (!readRational(in, graph.weight) || !(in >> blocks) || blocks > max_positions) { error = "bad graph"; return false; }
+        graph.blocks.resize(blocks);
+        for (auto& block : graph.blocks) {
+            size_t size = 0;
+            if (!(in >> size) || size > max_positions) { error = "bad block"; return false; }
+            block.resize(size);
+            for (int& half_edge : block) {
+                if (!(in >> half_edge)) { error = "bad block"; return false; }
+            }
+        }
+    }
+    if (!expect(in, "degree") || !readRational(in, certificate.degree_dual)) { error = "bad degree line"; return false; }
+    if (!expect(in, "duals") || !(in >> count)) { error = "bad duals line"; return false; }
+    for (size_t d = 0; d < count; ++d) {
+        CertificateDual& dual = certificate.gluing_duals.emplace_back();
+        size_t size = 0;
+        if (!(in >> size) || size > max_positions) { error = "bad dual"; return false; }
+        dual.key.resize(size);
+        for (int& position : dual.key) {
+            if (!(in >> position) || position == 0 || std::abs(position) > EquationConstruction::GluingKey::kMaxWordLength) { error = "bad dual key"; return false; }
+        }
+        if (!readRational(in, dual.value)) { error = "bad dual"; return false; }
+    }
+    if (!expect(in, "end")) { error = "missing end"; return false; }
+    return true;
+}
+
+CertificateCheck verifyCertificate(const OptimalityCertificate& certificate, bool check_dual) {
+    CertificateCheck check;
+    const int n = certificate.word.size();
+    std::unique_ptr<StableInvariant> invariant = make_invariant(certificate.problem_type, certificate.m);
+    if (!invariant) { check.error = "unsupported problem type"; return check; }
+    if (n == 0 || n > EquationConstruction::GluingKey::kMaxWordLength) { check.error = "bad word length"; return check; }
+    const CoreWhiteheadGraph core = constructCoreWhiteheadGraph(certificate.word, certificate.r);
+
+    KeyValues duals;
+    for (const auto& dual : certificate.gluing_duals) {
+        duals[keyOfPositions(dual.key)] += dual.value;
+    }
+
+    // Step 1: Every graph is a column with positive weight and reduced cost 0; accumulate the
+    // weight on each key, on the degree row and in the objective
+    KeyValues weight_of_key;
+    Exact::Rational degree_total, objective_total;
+    for (size_t g = 0; g < certificate.graphs.size(); ++g) {
+        const CertificateGraph& entry = certificate.graphs[g];
+        const std::string where = "graph " + std::to_string(g + 1) + ": ";
+        if (entry.weight.sign() <= 0) { check.error = where + "weight is not positive"; return check; }
+        std::unique_ptr<WhiteheadGraph> graph;
+        std::string error;
+        if (!buildColumnGraph(entry, certificate, core, *invariant, graph, error)) { check.error = where + error; return check; }
+
+        const ColumnData column = columnOf(*graph);
+        objective_total += entry.weight * column.objective;
+        if (column.first_letter) degree_total += entry.weight;
+        for (const auto& key : column.keys) {
+            weight_of_key[key] += entry.weight;
+        }
+        const Exact::Rational reduced_cost = column.objective - priceOf(column, duals, certificate.degree_dual, n);
+        if (reduced_cost.sign() != 0 || reduced_cost.overflowed()) {
+            check.error = where + "reduced cost is not 0 (complementary slackness)";
+            return check;
+        }
+    }
+
+    // Step 2: Primal feasibility; every gluing row only involves keys seen above
+    for (const auto& [key, weight] : weight_of_key) {
+        const Exact::Rational net = weight - valueOr0(weight_of_key, key.opposite(n));
+        if (net.sign() != 0 || net.overflowed()) {
+            check.error = "a gluing row is violated";
+            return check;
+        }
+    }
+    if (degree_total != Exact::Rational(1)) { check.error = "the degree row does not sum to 1"; return check; }
+
+    // Step 3: Primal and dual objectives match the claimed value (the degree row is the only
+    // row with a nonzero right-hand side)
+    if (objective_total != certificate.value) { check.error = "the primal objective differs from the value"; return check; }
+    if (certificate.degree_dual != certificate.value) { check.error = "the dual objective differs from the value"; return check; }
+    if (objective_total.overflowed() || degree_total.overflowed()) { check.error = "arithmetic overflow"; return check; }
+    check.valid = true;
+
+    // Step 4: Optionally, dual feasibility over every column of the LP. All unfoldings of a
+    // subgraph share its keys and degree flag, hence its price.
+    if (check_dual) {
+        check.dual_checked = true;
+        const bool unfold = certificate.problem_type != PROBLEM_TYPE::SPI_M;
+        bool feasible = true;
+        for (const WhiteheadGraph& subgraph : VariableConstruction::findValidSubgraphsFromCore(core, *invariant)) {
+            if (!feasible) break;
+            check.subgraphs_priced++;
+            const ColumnData column = columnOf(subgraph);
+            const Exact::Rational price = priceOf(column, duals, certificate.degree_dual, n);
+            if (price.overflowed()) {
+                feasible = false;
+                break;
+            }
+            if (!unfold) {
+                if (VariableConstruction::isValidUnfolding(subgraph, *invariant) && (column.objective - price).sign() > 0) feasible = false;
+                continue;
+            }
+            const Exact::Rational bound(static_cast<int64_t>(std::llround(EquationConstruction::getObjectiveUpperBound(subgraph))));
+            if ((bound - price).sign() <= 0) continue;
+            check.subgraphs_unfolded++;
+            VariableConstruction::forEachUnfolding(subgraph, [&](uint64_t, const WhiteheadGraph& graph) {
+                if (!feasible) return;
+                const Exact::Rational objective(static_cast<int64_t>(std::llround(EquationConstruction::getObjectiveCoefficient(graph))));
+                if ((objective - price).sign() <= 0) return;
+                if (VariableConstruction::isValidUnfolding(graph, *invariant)) feasible = false;
+            });
+        }
+        check.dual_feasible = feasible && !certificate.degree_dual.overflowed();
+        if (!feasible) check.error = "a column has positive reduced cost (dual infeasible)";
+    }
+    return check;
+}
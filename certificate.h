@@ -0,0 +1,59 @@
+#ifndef certificate_h
+#define certificate_h
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <cstdint>
+#include "rational.h"
+#include "runner.h"
+
+// A compact proof of the LP value of a word that can be re-checked without solving anything:
+// the graphs in the support of an optimal solution with their weights, and duals for the
+// gluing and degree rows. A graph is given by its vertices, each a block of signed half-edge
+// positions (+p for the tail of the edge at position p, -p for its head); the original vertex
+// of a block and the underlying subgraph of the core graph follow from the word.
+struct CertificateGraph {
+    Exact::Rational weight;
+    std::vector<std::vector<int>> blocks;
+};
+
+// Dual of the gluing row of `key`: the graphs containing the key minus those containing its
+// opposite key. Rows that are not listed have dual 0.
+struct CertificateDual {
+    std::vector<int> key; // signed positions
+    Exact::Rational value;
+};
+
+struct OptimalityCertificate {
+    PROBLEM_TYPE problem_type = PROBLEM_TYPE::SPI_NO_ORIGAMI;
+    int r = 0;
+    int m = -1;
+    std::vector<int> word;
+    Exact::Rational value;
+    std::vector<CertificateGraph> graphs;
+    Exact::Rational degree_dual;
+    std::vector<CertificateDual> gluing_duals;
+};
+
+void writeCertificate(std::ostream& out, const OptimalityCertificate& certificate);
+bool readCertificate(std::istream& in, OptimalityCertificate& certificate, std::string& error);
+
+struct CertificateCheck {
+    bool valid = false;         // primal feasible, complementary slackness, equal objectives
+    bool dual_checked = false;
+    bool dual_feasible = false; // no column of the LP has positive reduced cost
+    uint64_t subgraphs_priced = 0;
+    uint64_t subgraphs_unfolded = 0;
+    std::string error;          // first failed check
+};
+
+// Checks that every graph is a column of the LP of the word, that the weights satisfy every
+// gluing row and the degree row, that each support column has reduced cost 0 and that the
+// primal and dual objectives equal the claimed value, all in exact arithmetic and in time
+// linear in the certificate. With check_dual it also prices every valid subgraph of the word
+// against the duals, unfolding only those whose objective bound could beat their price; this
+// proves the value is the optimum, and is exponential in the word length but solves no LP.
+CertificateCheck verifyCertificate(const OptimalityCertificate& certificate, bool check_dual = false);
+
+#endif
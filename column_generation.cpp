@@ -0,0 +1,247 @@
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <glpk.h>
+#include "linear_program_construction.h"
+#include "thread_pool.h"
+
+// Column generation for the stable invariant LP.
+//
+// Every unfolding of a valid subgraph has the same gluing keys and the same first-letter flag
+// as the subgraph itself, so all of them share one constraint column and differ only in their
+// objective coefficient. The master LP therefore needs at most one column per subgraph: its
+// best valid unfolding. Columns are priced with the duals of the restricted master, and a
+// subgraph is only unfolded once the cheap bound on its objective coefficient says it could
+// improve the master.
+namespace {
+    struct SubgraphColumn {
+        std::vector<int> rows;          // master row numbers (1-based, gluing rows only)
+        std::vector<double> coefficients;
+        bool first_letter = false;
+        double upper_bound = 0;         // on the objective coefficient of any valid unfolding
+        bool evaluated = false;         // best unfolding known
+        bool has_valid_unfolding = false;
+        double best_objective = 0;
+        uint64_t best_unfolding = 0;
+        int master_column = 0;          // 0 while not in the master
+    };
+
+    // Gluing rows are the pairs {key, opposite key}; the smaller key of a pair enters with +1,
+    // the other with -1, and a key that is its own opposite gives an empty row
+    typedef EquationConstruction::GluingKey GluingKey;
+
+    SubgraphColumn makeColumn(const WhiteheadGraph& subgraph, int n, bool unfold, std::map<GluingKey, int>& row_of_pair) {
+        SubgraphColumn column;
+        std::map<int, double> coefficient_of_row;
+        for (const GluingKey& key : EquationConstruction::getGluingKeys(subgraph)) {
+            const GluingKey opposite = key.opposite(n);
+            if (key == opposite) continue;
+            const bool is_first = key < opposite;
+            const GluingKey& pair = is_first ? key : opposite;
+            auto it = row_of_pair.find(pair);
+            if (it == row_of_pair.end()) {
+                it = row_of_pair.emplace(pair, static_cast<int>(row_of_pair.size()) + 1).first;
+            }
+            coefficient_of_row[it->second] += is_first ? 1.0 : -1.0;
+        }
+        for (const auto& [row, coefficient] : coefficient_of_row) {
+            if (coefficient == 0) continue;
+            column.rows.push_back(row);
+            column.coefficients.push_back(coefficient);
+        }
+        column.first_letter = EquationConstruction::hasFirstLetterEdge(subgraph);
+
+        if (unfold) column.upper_bound = EquationConstruction::getObjectiveUpperBound(subgraph);
+        return column;
+    }
+
+    void evaluateColumn(SubgraphColumn& column, const WhiteheadGraph& subgraph, StableInvariant& invariant, bool unfold) {
+        if (!unfold) {
+            column.has_valid_unfolding = VariableConstruction::isValidUnfolding(subgraph, invariant);
+            column.best_objective = EquationConstruction::getObjectiveCoefficient(subgraph);
+            column.upper_bound = column.best_objective;
+        } else {
+            VariableConstruction::forEachUnfolding(subgraph, [&](uint64_t index, const WhiteheadGraph& graph) {
+                const double objective = EquationConstruction::getObjectiveCoefficient(graph);
+                if (column.has_valid_unfolding && objective <= column.best_objective) return;
+                if (!VariableConstruction::isValidUnfolding(graph, invariant)) return;
+                column.has_valid_unfolding = true;
+                column.best_objective = objective;
+                column.best_unfolding = index;
+            });
+            assert((!column.has_valid_unfolding || column.best_objective <= column.upper_bound) && "objective bound is wrong");
+        }
+        column.evaluated = true;
+    }
+
+    // Checks in exact arithmetic that no subgraph outside the master prices out against the
+    // duals held by lp, rationalized as certifyExactOptimum does. A subgraph whose objective
+    // bound does not settle it is unfolded first.
+    bool pricesOutExactly(glp_prob *lp, std::vector<SubgraphColumn>& columns, const std::vector<WhiteheadGraph>& validSubgraphs,
+                          StableInvariant& invariant, bool unfold, int degree_row) {
+        const int64_t max_denominator = 1000000;
+        std::vector<Exact::Rational> duals(degree_row + 1);
+        for (int i = 1; i <= degree_row; ++i) {
+            duals[i] = Exact::rationalize(glp_get_row_dual(lp, i), max_denominator);
+        }
+        for (size_t s = 0; s < columns.size(); ++s) {
+            SubgraphColumn& column = columns[s];
+            if (column.master_column != 0) continue;
+            Exact::Rational price = column.first_letter ? duals[degree_row] : Exact::Rational();
+            for (size_t k = 0; k < column.rows.size(); ++k) {
+                price += Exact::rationalize(column.coefficients[k], max_denominator) * duals[column.rows[k]];
+            }
+            if (!column.evaluated) {
+                const Exact::Rational optimistic = Exact::rationalize(column.upper_bound, max_denominator) - price;
+                if (optimistic.sign() <= 0 && !optimistic.overflowed()) continue;
+                evaluateColumn(column, validSubgraphs[s], invariant, unfold);
+            }
+            if (!column.has_valid_unfolding) continue;
+            const Exact::Rational reduced_cost = Exact::rationalize(column.best_objective, max_denominator) - price;
+            if (reduced_cost.sign() > 0 || reduced_cost.overflowed()) return false;
+        }
+        return true;
+    }
+}
+
+ColumnGenerationResult solveByColumnGeneration(const std::vector<WhiteheadGraph>& validSubgraphs, int n, StableInvariant& invariant, bool unfold, int threads, Exact::Optimum* exact) {
+    ColumnGenerationResult result;
+    const double epsilon = 1e-9;
+    const double big_m = 1e6; // cost of the artificial column that keeps the master feasible
+
+    // Step 1: Constraint columns and objective bounds of every subgraph
+    std::map<GluingKey, int> row_of_pair;
+    std::vector<SubgraphColumn> columns;
+    columns.reserve(validSubgraphs.size());
+    for (const auto& subgraph : validSubgraphs) {
+        columns.push_back(makeColumn(subgraph, n, unfold, row_of_pair));
+        if (!unfold) evaluateColumn(columns.back(), subgraph, invariant, unfold); // the subgraph is its only column
+    }
+    const int num_gluing_rows = row_of_pair.size();
+    const int degree_row = num_gluing_rows + 1;
+    result.rows = degree_row;
+
+    // Step 2: Master LP with every row and only the artificial column
+    glp_prob *lp = glp_create_prob();
+    glp_set_obj_dir(lp, GLP_MAX);
+    glp_add_rows(lp, degree_row);
+    for (int i = 1; i <= num_gluing_rows; ++i) {
+        glp_set_row_bnds(lp, i, GLP_FX, 0.0, 0.0);
+    }
+    glp_set_row_bnds(lp, degree_row, GLP_FX, 1.0, 1.0);
+    glp_add_cols(lp, 1);
+    glp_set_col_bnds(lp, 1, GLP_LO, 0.0, 0.0);
+    glp_set_obj_coef(lp, 1, -big_m);
+    {
+        const int ind[2] = {0, degree_row};
+        const double val[2] = {0.0, 1.0};
+        glp_set_mat_col(lp, 1, 1, ind, val);
+    }
+
+    glp_term_out(GLP_OFF);
+    glp_smcp parm;
+    glp_init_smcp(&parm);
+    parm.msg_lev = GLP_MSG_OFF;
+
+    std::vector<int> master_subgraphs; // subgraph of master column j + 2
+    std::vector<double> duals(degree_row + 1);
+    bool solved = false;
+    while (true) {
+        // Step 3: Solve the restricted master
+        result.rounds++;
+        const int status = glp_simplex(lp, &parm);
+        if (status != 0 || glp_get_status(lp) != GLP_OPT) break;
+        for (int i = 1; i <= degree_row; ++i) {
+            duals[i] = glp_get_row_dual(lp, i);
+        }
+
+        // Step 4: Price every subgraph that is not in the master yet. The reduced cost of its
+        // best column is best_objective - price; before it is unfolded, the objective bound
+        // gives an optimistic reduced cost. Candidates are visited most promising first.
+        std::vector<double> prices(columns.size());
+        std::vector<std::pair<double, size_t>> candidates; // (optimistic reduced cost, subgraph)
+        for (size_t s = 0; s < columns.size(); ++s) {
+            const SubgraphColumn& column = columns[s];
+            if (column.master_column != 0) continue;
+            if (column.evaluated && !column.has_valid_unfolding) continue;
+            double price = column.first_letter ? duals[degree_row] : 0.0;
+            for (size_t k = 0; k < column.rows.size(); ++k) {
+                price += column.coefficients[k] * duals[column.rows[k]];
+            }
+            prices[s] = price;
+            const double optimistic = (column.evaluated ? column.best_objective : column.upper_bound) - price;
+            if (optimistic > epsilon) candidates.emplace_back(optimistic, s);
+        }
+        std::stable_sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+        // Step 5: Unfold candidates in batches and add every column with positive reduced cost;
+        // stop after the first batch that adds one, and stop altogether when no candidate does
+        const size_t batch_size = std::max(8, 2 * Parallel::resolveThreadCount(threads));
+        int added = 0;
+        for (size_t first = 0; first < candidates.size() && added == 0; first += batch_size) {
+            const size_t last = std::min(candidates.size(), first + batch_size);
+            std::vector<size_t> to_evaluate;
+            for (size_t i = first; i < last; ++i) {
+                if (!columns[candidates[i].second].evaluated) to_evaluate.push_back(candidates[i].second);
+            }
+            Parallel::parallelFor(to_evaluate.size(), threads, [&](size_t i) {
+                const size_t s = to_evaluate[i];
+                evaluateColumn(columns[s], validSubgraphs[s], invariant, unfold);
+            });
+            result.subgraphs_unfolded += to_evaluate.size();
+
+            for (size_t i = first; i < last; ++i) {
+                const size_t s = candidates[i].second;
+                SubgraphColumn& column = columns[s];
+                if (!column.has_valid_unfolding || column.best_objective <= prices[s] + epsilon) continue;
+
+                std::vector<int> ind = {0};
+                std::vector<double> val = {0.0};
+                ind.insert(ind.end(), column.rows.begin(), column.rows.end());
+                val.insert(val.end(), column.coefficients.begin(), column.coefficients.end());
+                if (column.first_letter) {
+                    ind.push_back(degree_row);
+                    val.push_back(1.0);
+                }
+                column.master_column = glp_add_cols(lp, 1);
+                glp_set_col_bnds(lp, column.master_column, GLP_LO, 0.0, 0.0);
+                glp_set_obj_coef(lp, column.master_column, column.best_objective);
+                glp_set_mat_col(lp, column.master_column, ind.size() - 1, ind.data(), val.data());
+                master_subgraphs.push_back(static_cast<int>(s));
+                added++;
+            }
+        }
+        if (added == 0) {
+            solved = true;
+            break;
+        }
+    }
+
+    // Step 6: The full LP is infeasible if the artificial column is still needed
+    if (solved && glp_get_col_prim(lp, 1) <= epsilon) {
+        result.objective = glp_get_obj_val(lp);
+        // The certified optimum of the final master is only a lower bound until every other
+        // column prices out exactly against the same duals; then it is the optimum of the full
+        // LP as well (the artificial column must be exactly zero)
+        if (exact && certifyExactOptimum(lp, *exact)) {
+            exact->certified = Exact::rationalize(glp_get_col_prim(lp, 1), 1000000).sign() == 0 &&
+                               pricesOutExactly(lp, columns, validSubgraphs, invariant, unfold, degree_row);
+        }
+        for (size_t j = 0; j < master_subgraphs.size(); ++j) {
+            const SubgraphColumn& column = columns[master_subgraphs[j]];
+            result.columns.push_back({master_subgraphs[j], column.best_unfolding, column.best_objective,
+                                      glp_get_col_prim(lp, static_cast<int>(j) + 2)});
+        }
+    }
+
+    const bool verbose = false;
+    if (verbose) {
+        std::cout << "Column generation: " << result.rounds << " rounds, " << master_subgraphs.size()
+                  << " columns, " << result.subgraphs_unfolded << " subgraphs unfolded" << std::endl;
+    }
+
+    glp_delete_prob(lp);
+    return result;
+}
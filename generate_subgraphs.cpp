@@ -3,6 +3,8 @@
 #include <list>
 #include <algorithm>
 #include <unordered_set>
+#include <cassert>
+#include <cstdint>
 #include "WhiteheadGraph.h"
 #include "stable_invariants_types.h"
 #include "linear_program_construction.h"
@@ -10,23 +12,147 @@
 #include <sstream>
 
 namespace VariableConstruction {
-    // Helper function to generate all subsets of a set of edges
-    std::vector<std::vector<Edge>> generateSubsets(const std::vector<Edge>& edges) {
-        std::vector<std::vector<Edge>> subsets;
-        int n = edges.size();
-        int num_subsets = 1 << n; // 2^n subsets
-
-        for (int i = 0; i < num_subsets; ++i) {
-            std::vector<Edge> subset;
+    // Dense index of a core vertex: +k -> 2(k-1), -k -> 2(k-1)+1
+    static int coreVertexIndex(int vertex) {
+        return vertex > 0 ? 2 * (vertex - 1) : 2 * (-vertex - 1) + 1;
+    }
+
+    // Backtracking search over core edge subsets. Edges are decided from the highest index
+    // down with "exclude" tried first, so subsets are reached in increasing mask order.
+    // A branch is cut once a touched vertex can no longer reach degree 2, or once the
+    // touched vertices can no longer be joined using chosen and undecided edges; the adjacency
+    // masks of those edges and the touched mask are kept up to date as edges are decided. With
+    // bounds, branches that cannot end within the edge count range are cut too.
+    class PrunedSubsetSearch {
+    public:
+        PrunedSubsetSearch(const std::vector<Edge>& edges, int r, const std::function<void(uint64_t)>& callback,
+                           SubgraphSearchStats* stats, const SubgraphSearchBounds* bounds)
+            : n(edges.size()), callback(callback), stats(stats), bounds(bounds),
+              vertices(2 * r), start_index(n), end_index(n), degree(2 * r, 0), remaining(2 * r, 0),
+              multiplicity(4 * r * r, 0), adjacency(2 * r, 0) {
+            assert(n < 64 && "word too long for 64-bit subset masks");
+            assert(2 * r <= 64 && "rank too large for 64-bit vertex masks");
             for (int j = 0; j < n; ++j) {
-                if (i & (1 << j)) {
-                    subset.push_back(edges[j]);
+                start_index[j] = coreVertexIndex(edges[j].start);
+                end_index[j] = coreVertexIndex(edges[j].end);
+                remaining[start_index[j]]++;
+                remaining[end_index[j]]++;
+                setAvailable(start_index[j], end_index[j], 1);
+            }
+        }
+
+        void run() {
+            decide(n - 1);
+            if (stats) stats->stopped = stopped;
+        }
+
+    private:
+        const int n;
+        const std::function<void(uint64_t)>& callback;
+        SubgraphSearchStats* stats;
+        const SubgraphSearchBounds* bounds;
+        const int vertices;
+        std::vector<int> start_index, end_index;
+        std::vector<int> degree, remaining;
+        std::vector<int> multiplicity;   // chosen and undecided edges between each pair of vertices
+        std::vector<uint64_t> adjacency; // per vertex, the neighbours with nonzero multiplicity
+        uint64_t touched = 0;            // vertices of nonzero degree
+        uint64_t mask = 0;
+        int chosen_edges = 0;
+        uint64_t nodes = 0;
+        bool stopped = false;
+
+        // The clock is read every 4096 nodes
+        bool pastDeadline() {
+            if (!bounds || (++nodes & 4095) != 0) return stopped;
+            stopped = stopped || std::chrono::steady_clock::now() >= bounds->deadline;
+            return stopped;
+        }
+
+        bool canReachEdgeCount(int undecided) const {
+            return !bounds || (chosen_edges <= bounds->max_edges && chosen_edges + undecided >= bounds->min_edges);
+        }
+
+        bool canReachDegree(int v) const {
+            return degree[v] == 0 || degree[v] + remaining[v] >= 2;
+        }
+
+        void adjustMultiplicity(int u, int v, int delta) {
+            int& count = multiplicity[u * vertices + v];
+            count += delta;
+            if (count > 0) adjacency[u] |= uint64_t(1) << v;
+            else adjacency[u] &= ~(uint64_t(1) << v);
+        }
+
+        // An edge between s and e leaves (-1) or rejoins (+1) the chosen and undecided edges
+        void setAvailable(int s, int e, int delta) {
+            adjustMultiplicity(s, e, delta);
+            adjustMultiplicity(e, s, delta);
+        }
+
+        void adjustDegree(int v, int delta) {
+            degree[v] += delta;
+            if (degree[v] > 0) touched |= uint64_t(1) << v;
+            else touched &= ~(uint64_t(1) << v);
+        }
+
+        // Checks that all touched vertices lie in one component of chosen + undecided edges
+        bool canStayConnected() const {
+            if (chosen_edges == 0) return true;
+            uint64_t reached = touched & (~touched + 1); // lowest touched vertex
+            uint64_t frontier = reached;
+            while (frontier) {
+                const int v = __builtin_ctzll(frontier);
+                frontier &= frontier - 1;
+                const uint64_t fresh = adjacency[v] & ~reached;
+                reached |= fresh;
+                frontier |= fresh;
+            }
+            return (touched & ~reached) == 0;
+        }
+
+        void decide(int j) {
+            if (pastDeadline()) return;
+            if (stats) stats->explored++;
+            if (j < 0) {
+                if (chosen_edges >= 2 && canReachEdgeCount(0)) {
+                    if (stats) stats->emitted++;
+                    callback(mask);
                 }
+                return;
+            }
+            const int s = start_index[j];
+            const int e = end_index[j];
+            remaining[s]--;
+            remaining[e]--;
+
+            // Branch 1: leave edge j out
+            setAvailable(s, e, -1);
+            if (canReachDegree(s) && canReachDegree(e) && canReachEdgeCount(j) && canStayConnected()) {
+                decide(j - 1);
+            }
+            setAvailable(s, e, 1);
+
+            // Branch 2: take edge j
+            mask |= uint64_t(1) << j;
+            chosen_edges++;
+            adjustDegree(s, 1);
+            adjustDegree(e, 1);
+            if (canReachDegree(s) && canReachDegree(e) && canReachEdgeCount(j) && canStayConnected()) {
+                decide(j - 1);
             }
-            subsets.push_back(subset);
+            adjustDegree(s, -1);
+            adjustDegree(e, -1);
+            chosen_edges--;
+            mask &= ~(uint64_t(1) << j);
+
+            remaining[s]++;
+            remaining[e]++;
         }
+    };
 
-        return subsets;
+    void forEachPrunedSubset(const std::vector<Edge>& edges, int r, const std::function<void(uint64_t)>& callback, SubgraphSearchStats* stats, const SubgraphSearchBounds* bounds) {
+        PrunedSubsetSearch(edges, r, callback, stats, bounds).run();
     }
 
     // Helper function to build a subgraph induced by a subset of edges
@@ -49,25 +175,55 @@ namespace VariableConstruction {
     }
 
     // Main function to find all subgraphs with minimum vertex degree 2
-    std::vector<WhiteheadGraph> findValidSubgraphsFromCore(const CoreWhiteheadGraph& graph, StableInvariant& invariant) {
+    std::vector<WhiteheadGraph> findValidSubgraphsFromCore(const CoreWhiteheadGraph& graph, StableInvariant& invariant, SubgraphSearchStats* stats, const SubgraphSearchBounds* bounds) {
         std::vector<WhiteheadGraph> validSubgraphs;
-
-        // Generate all subsets of the edge set
         std::vector<Edge> edges = graph.getAllEdges();
-        std::vector<std::vector<Edge>> subsets = generateSubsets(edges);
 
-        // For each subset, build the subgraph and check its minimum vertex degree
-        for (const std::vector<Edge>& subset : subsets) {
+        // The pruned search yields candidates in increasing mask order, so LP variable
+        // indices match the plain binary enumeration
+        std::vector<Edge> subset;
+        forEachPrunedSubset(edges, graph.getR(), [&](uint64_t mask) {
+            subset.clear();
+            for (size_t j = 0; j < edges.size(); ++j) {
+                if (mask & (uint64_t(1) << j)) {
+                    subset.push_back(edges[j]);
+                }
+            }
             WhiteheadGraph subgraph = buildSubgraph(graph, subset);
             subgraph.removeIsolatedVertices();
-            // std::cout<<"trying graph: \n";
-            // subgraph.displayGraph();
             const Graph subgraph_graph(subgraph);
-            if (!subset.empty() && invariant.isValidWHGraphForInvariant(subgraph_graph)) {
+            if (invariant.isValidWHGraphForInvariant(subgraph_graph)) {
                 validSubgraphs.push_back(subgraph);
             }
-        }
+        }, stats, bounds);
 
         return validSubgraphs;
     }
-}
\ No newline at end of file
+
+    bool isInMinimumDegreeCore(const CoreWhiteheadGraph& graph, int position) {
+        const std::vector<Edge> edges = graph.getAllEdges();
+        std::vector<int> degree(2 * graph.getR(), 0);
+        for (const Edge& edge : edges) {
+            degree[coreVertexIndex(edge.start)]++;
+            degree[coreVertexIndex(edge.end)]++;
+        }
+        std::vector<char> deleted(edges.size(), 0);
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (size_t j = 0; j < edges.size(); ++j) {
+                const int s = coreVertexIndex(edges[j].start);
+                const int e = coreVertexIndex(edges[j].end);
+                if (deleted[j] || (degree[s] >= 2 && degree[e] >= 2)) continue;
+                deleted[j] = 1;
+                degree[s]--;
+                degree[e]--;
+                changed = true;
+            }
+        }
+        for (size_t j = 0; j < edges.size(); ++j) {
+            if (edges[j].position == position) return !deleted[j];
+        }
+        return false;
+    }
+}
@@ -1,102 +1,173 @@
 #include <vector>
-#include <set>
-#include <unordered_map>
-#include <unordered_set>
+#include <algorithm>
 #include "WhiteheadGraph.h"
 #include "stable_invariants_types.h"
+#include "linear_program_construction.h"
 #include <iostream>
 
 namespace EquationConstruction{
-    // Custom hash function for set of sets
-    struct SetOfSetsHash {
-        std::size_t operator()(const std::set<std::set<int>>& s) const {
-            std::size_t seed = 0;
-            for (const auto& inner_set : s) {
-                for (int i : inner_set) {
-                    seed ^= std::hash<int>{}(i) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
-                }
-            }
-            return seed;
+    GluingKey::Bits GluingKey::rotateUp(const Bits& bits, int n) {
+        // bit i -> bit i+1, and bit n-1 -> bit 0
+        Bits result{};
+        uint64_t carry = (bits[(n - 1) / 64] >> ((n - 1) % 64)) & 1;
+        for (int w = 0; w < kWords; ++w) {
+            result[w] = (bits[w] << 1) | carry;
+            carry = bits[w] >> 63;
         }
-    };
+        if (n < kMaxWordLength) result[n / 64] &= ~(uint64_t(1) << (n % 64));
+        return result;
+    }
 
-    std::unordered_map<std::set<std::set<int>>, std::vector<int>, SetOfSetsHash> calculateGluingRestrictions(const std::vector<WhiteheadGraph>& graphs) {
-        std::unordered_map<std::set<std::set<int>>, std::vector<int>, SetOfSetsHash> gluing_restrictions;
+    GluingKey::Bits GluingKey::rotateDown(const Bits& bits, int n) {
+        // bit i -> bit i-1, and bit 0 -> bit n-1
+        Bits result{};
+        for (int w = 0; w < kWords; ++w) {
+            result[w] = (bits[w] >> 1) | (w + 1 < kWords ? bits[w + 1] << 63 : 0);
+        }
+        if (bits[0] & 1) result[(n - 1) / 64] |= uint64_t(1) << ((n - 1) % 64);
+        return result;
+    }
 
-        for (size_t i = 0; i < graphs.size(); ++i) {
-            const auto& graph = graphs[i];
-            const auto& original_vertices = graph.getOriginalVertices();
-            const auto& edges_by_position = graph.getEdgesByPosition();
-
-            std::unordered_map<int, std::set<int>> original_to_positions;
-
-            // Group positions by original vertex
-            for (const auto& [new_vertex, original_vertex] : original_vertices) {
-                for (const auto& [position, edge] : edges_by_position) {
-                    if (edge.first == new_vertex) {
-                        original_to_positions[original_vertex].insert(position);
-                    } else if (edge.second == new_vertex) {
-                        original_to_positions[original_vertex].insert(-position);
-                    }
+    GluingKey GluingKey::opposite(int n) const {
+        // Outgoing p becomes incoming p-1 and incoming p becomes outgoing p+1, cyclically
+        GluingKey result;
+        result.out = rotateUp(in, n);
+        result.in = rotateDown(out, n);
+        return result;
+    }
+
+    std::vector<int> GluingKey::positions() const {
+        std::vector<int> result;
+        for (int sign : {1, -1}) {
+            const Bits& bits = sign > 0 ? out : in;
+            for (int w = 0; w < kWords; ++w) {
+                for (uint64_t word = bits[w]; word != 0; word &= word - 1) {
+                    result.push_back(sign * (64 * w + __builtin_ctzll(word) + 1));
                 }
             }
+        }
+        return result;
+    }
 
-            // Create partition of positions for each original vertex
-            for (const auto& [original_vertex, positions] : original_to_positions) {
-                std::set<std::set<int>> partition_of_positions;
-                partition_of_positions.insert(positions);
+    std::size_t GluingKey::hash() const {
+        auto mix = [](uint64_t x) { // splitmix64 finalizer
+            x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+            return x ^ (x >> 31);
+        };
+        uint64_t seed = 0;
+        for (int w = 0; w < kWords; ++w) {
+            seed = mix(seed ^ out[w]);
+            seed = mix(seed ^ in[w]);
+        }
+        return static_cast<std::size_t>(seed);
+    }
 
-                auto it = gluing_restrictions.find(partition_of_positions);
-                if (it == gluing_restrictions.end()) {
-                    gluing_restrictions[partition_of_positions] = {static_cast<int>(i)};
-                } else {
-                    it->second.push_back(static_cast<int>(i));
-                }
-            }
+    size_t GluingRestrictions::slotOf(const GluingKey& key) const {
+        const size_t mask = slots.size() - 1;
+        size_t slot = key.hash() & mask;
+        while (slots[slot] != 0 && entries[slots[slot] - 1].first != key) {
+            slot = (slot + 1) & mask;
         }
+        return slot;
+    }
 
-        return gluing_restrictions;
+    void GluingRestrictions::grow() {
+        slots.assign(std::max<size_t>(16, 2 * slots.size()), 0);
+        for (size_t i = 0; i < entries.size(); ++i) {
+            slots[slotOf(entries[i].first)] = i + 1;
+        }
     }
-    const std::set<std::set<int>> getOppositePartition(const std::set<std::set<int>>& partition, const int n){
-        std::set<std::set<int>> opposite_partition;
-        for (const auto& s : partition) {
-            std::set<int> opposite_set;
-            for (int position : s) {
-                if (position > 1) {
-                    opposite_set.insert(-(position - 1));
-                } else if (position == 1) {
-                    opposite_set.insert(-n);
-                } else if (position <= -1 && position > -n) {
-                    opposite_set.insert(-position + 1);
-                } else { // position == -n
-                    opposite_set.insert(1);
-                }
+
+    std::vector<int>& GluingRestrictions::operator[](const GluingKey& key) {
+        if (2 * (entries.size() + 1) > slots.size()) grow(); // load factor at most 1/2
+        const size_t slot = slotOf(key);
+        if (slots[slot] == 0) {
+            entries.emplace_back(key, std::vector<int>());
+            slots[slot] = entries.size();
+        }
+        return entries[slots[slot] - 1].second;
+    }
+
+    int GluingRestrictions::indexOf(const GluingKey& key) const {
+        if (slots.empty()) return -1;
+        return slots[slotOf(key)] - 1;
+    }
+
+    // Gluing key of each original vertex of the graph, in order of the original vertex. One
+    // pass over the edges; a graph has at most 2r original vertices, so they are found by a
+    // linear scan.
+    std::vector<GluingKey> getGluingKeys(const WhiteheadGraph& graph) {
+        std::vector<std::pair<int, GluingKey>> original_to_key;
+        auto key_of = [&](int original_vertex) -> GluingKey& {
+            for (auto& entry : original_to_key) {
+                if (entry.first == original_vertex) return entry.second;
             }
-            opposite_partition.insert(opposite_set);
+            original_to_key.emplace_back(original_vertex, GluingKey());
+            return original_to_key.back().second;
+        };
+        for (const auto& [position, edge] : graph.getEdgesByPosition()) {
+            key_of(graph.getOriginalVertex(edge.first)).addOutgoing(position);
+            key_of(graph.getOriginalVertex(edge.second)).addIncoming(position);
         }
-        return opposite_partition;
+        std::sort(original_to_key.begin(), original_to_key.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+        std::vector<GluingKey> keys;
+        keys.reserve(original_to_key.size());
+        for (const auto& entry : original_to_key) {
+            keys.push_back(entry.second);
+        }
+        return keys;
     }
 
-    std::vector<std::pair<std::vector<int>, std::vector<int>>> processGluingRestrictions(const std::unordered_map<std::set<std::set<int>>, std::vector<int>, SetOfSetsHash>& gluingRestrictions, int n) {
-        std::unordered_set<std::set<std::set<int>>, SetOfSetsHash> visited;
-        std::vector<std::pair<std::vector<int>, std::vector<int>>> output; // pairs of inverse half-edges.
+    static void addGluingKeys(GluingRestrictions& gluing_restrictions, const WhiteheadGraph& graph, int index) {
+        for (const GluingKey& key : getGluingKeys(graph)) {
+            gluing_restrictions[key].push_back(index);
+        }
+    }
 
-        for (const auto& [key, value] : gluingRestrictions) {
-            const auto& opposite_partition = getOppositePartition(key, n);
+    GluingRestrictions calculateGluingRestrictions(const std::vector<WhiteheadGraph>& graphs) {
+        GluingRestrictions gluing_restrictions;
+        for (size_t i = 0; i < graphs.size(); ++i) {
+            addGluingKeys(gluing_restrictions, graphs[i], static_cast<int>(i));
+        }
+        return gluing_restrictions;
+    }
+
+    void LinearProgramData::addGraph(const WhiteheadGraph& graph) {
+        const int index = static_cast<int>(numGraphs());
+        objective.push_back(getObjectiveCoefficient(graph));
+        if (hasFirstLetterEdge(graph)) first_letter_indices.push_back(index);
+        addGluingKeys(gluing_restrictions, graph, index);
+    }
 
-            std::vector<int> opposite_value;
-            auto it = gluingRestrictions.find(opposite_partition);
-            if (it != gluingRestrictions.end()) {
-                opposite_value = it->second;
+    void LinearProgramData::append(LinearProgramData&& other) {
+        const int offset = static_cast<int>(numGraphs());
+        objective.insert(objective.end(), other.objective.begin(), other.objective.end());
+        for (const int index : other.first_letter_indices) {
+            first_letter_indices.push_back(index + offset);
+        }
+        for (auto& [key, indices] : other.gluing_restrictions) {
+            std::vector<int>& merged = gluing_restrictions[key];
+            for (const int index : indices) {
+                merged.push_back(index + offset);
             }
+        }
+        other = LinearProgramData();
+    }
 
-            std::vector<int> value_vec(value.begin(), value.end());
+    std::vector<std::pair<std::vector<int>, std::vector<int>>> processGluingRestrictions(const GluingRestrictions& gluingRestrictions, int n, std::vector<GluingKey>* row_keys = nullptr) {
+        std::vector<char> visited(gluingRestrictions.size(), 0);
+        std::vector<std::pair<std::vector<int>, std::vector<int>>> output; // pairs of inverse half-edges.
 
-            if (visited.find(key) == visited.end() && visited.find(opposite_partition) == visited.end()) {
-                output.emplace_back(value_vec, opposite_value);
-                visited.insert(key);
-                visited.insert(opposite_partition);
-            }
+        for (int i = 0; i < static_cast<int>(gluingRestrictions.size()); ++i) {
+            if (visited[i]) continue;
+            const auto& [key, value] = gluingRestrictions.entry(i);
+            const int opposite = gluingRestrictions.indexOf(key.opposite(n));
+            visited[i] = 1;
+            if (opposite >= 0) visited[opposite] = 1;
+            output.emplace_back(value, opposite >= 0 ? gluingRestrictions.entry(opposite).second : std::vector<int>());
+            if (row_keys) row_keys->push_back(key);
         }
         return output;
     }
@@ -106,4 +177,9 @@ namespace EquationConstruction{
         const auto& constraint_pairs = processGluingRestrictions(constraint_map, n);
         return constraint_pairs;
     }
+
+    std::vector<std::pair<std::vector<int>, std::vector<int>>> getGluingEquations(const LinearProgramData& data, int n, std::vector<GluingKey>* row_keys){
+        if (row_keys) row_keys->clear();
+        return processGluingRestrictions(data.gluing_restrictions, n, row_keys);
+    }
 }
\ No newline at end of file
@@ -2,31 +2,94 @@
 #define linear_program_construction_h
 
 #include <vector>
+#include <set>
 #include <unordered_map>
 #include <list>
 #include <unordered_set>
 #include <algorithm>
+#include <functional>
+#include <cstdint>
+#include <array>
+#include <cassert>
+#include <string>
+#include <memory>
+#include <chrono>
 #include <glpk.h>
 
 #include "WhiteheadGraph.h"
 #include "CoreWhiteheadGraph.h"
 #include "linear_program_construction.h"
 #include "stable_invariants_types.h"
+#include "utils.h"
+#include "rational.h"
+#include "lp_backend.h"
 
 
 namespace VariableConstruction {
 
+    // Node counters of the pruned subgraph search
+    struct SubgraphSearchStats {
+        uint64_t explored = 0;
+        uint64_t emitted = 0;
+        bool stopped = false; // the deadline cut the search short
+    };
+
+    // Restricts the pruned search to subsets of min_edges..max_edges core edges and stops it
+    // at a deadline, for searching the subgraph family in stages
+    struct SubgraphSearchBounds {
+        int min_edges = 2;
+        int max_edges = 64;
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    };
+
+    // Combination counters of the unfolding step: how many per-vertex partition combinations
+    // exist in total (saturating) versus how many singleton-free ones were generated
+    struct UnfoldingStats {
+        uint64_t possible_combinations = 0;
+        uint64_t generated_combinations = 0;
+    };
+
     // Declaration of functions from generate_subgraphs.cpp
-    std::vector<std::vector<Edge>> generateSubsets(const std::vector<Edge>& edges);
+    void forEachPrunedSubset(const std::vector<Edge>& edges, int r, const std::function<void(uint64_t)>& callback, SubgraphSearchStats* stats = nullptr, const SubgraphSearchBounds* bounds = nullptr);
 
     WhiteheadGraph buildSubgraph(const CoreWhiteheadGraph& graph, const std::vector<Edge>& subset);
 
-    std::vector<WhiteheadGraph> findValidSubgraphsFromCore(const CoreWhiteheadGraph& graph, StableInvariant& invariant);
+    std::vector<WhiteheadGraph> findValidSubgraphsFromCore(const CoreWhiteheadGraph& graph, StableInvariant& invariant, SubgraphSearchStats* stats = nullptr, const SubgraphSearchBounds* bounds = nullptr);
+
+    // Whether some subgraph of minimum degree 2 contains the core edge at `position`, i.e.
+    // whether the edge survives repeatedly deleting edges at vertices of degree below 2
+    bool isInMinimumDegreeCore(const CoreWhiteheadGraph& graph, int position);
 
 
     // Declaration of functions from unfolding.cpp
 
-    std::vector<WhiteheadGraph> partitionAndReplaceVertices(const WhiteheadGraph& subgraph);
+    void forEachPartitionCombination(const std::vector<std::vector<int>>& half_edges,
+                                     const std::function<void(const std::vector<Utils::SetPartitionGenerator>&)>& callback,
+                                     UnfoldingStats* stats = nullptr);
+
+    // Calls callback(index, graph) for every unfolding of the subgraph; index is the position
+    // of the partition combination in the enumeration, so replayUnfolding can rebuild it later
+    void forEachUnfolding(const WhiteheadGraph& subgraph, const std::function<void(uint64_t, const WhiteheadGraph&)>& callback, UnfoldingStats* stats = nullptr);
+
+    WhiteheadGraph replayUnfolding(const WhiteheadGraph& subgraph, uint64_t index);
+
+    // replayUnfolding for many indices of one subgraph: the half-edges and the per-vertex
+    // partition counts are collected once, and each replay only steps the generators
+    class UnfoldingReplayer {
+    public:
+        explicit UnfoldingReplayer(const WhiteheadGraph& subgraph);
+        WhiteheadGraph replay(uint64_t index) const;
+
+    private:
+        std::vector<int> vertices;
+        std::vector<std::vector<int>> half_edges;
+        std::vector<uint64_t> partition_counts; // singleton-free partitions at each vertex
+        int max_position = 0;
+    };
+
+    std::vector<WhiteheadGraph> partitionAndReplaceVertices(const WhiteheadGraph& subgraph, UnfoldingStats* stats = nullptr);
+
+    bool isValidUnfolding(const WhiteheadGraph& graph, StableInvariant& invariant);
 
     std::vector<WhiteheadGraph> filterValidWhiteheadGraphsFromPartitions(const std::vector<WhiteheadGraph>& graphs, StableInvariant& invariant);
 
@@ -34,15 +97,216 @@ namespace VariableConstruction {
 
 namespace EquationConstruction{
 
+    // Half-edge positions at one original vertex as a bitmask: outgoing position p is bit p-1
+    // of `out`, incoming position p is bit p-1 of `in`. Outgoing p is glued to incoming p-1
+    // (and 1 to n), so the opposite key is a one-bit rotation of each half within n bits.
+    class GluingKey {
+    public:
+        static constexpr int kMaxWordLength = 128;
+
+        void addOutgoing(int position) { set(out, position); }
+        void addIncoming(int position) { set(in, position); }
+        GluingKey opposite(int n) const;
+
+        bool operator==(const GluingKey& other) const { return out == other.out && in == other.in; }
+        bool operator!=(const GluingKey& other) const { return !(*this == other); }
+        bool operator<(const GluingKey& other) const { return out != other.out ? out < other.out : in < other.in; }
+        std::size_t hash() const;
+        std::vector<int> positions() const; // outgoing as +p, then incoming as -p
+
+    private:
+        static constexpr int kWords = kMaxWordLength / 64;
+        typedef std::array<uint64_t, kWords> Bits;
+        Bits out{};
+        Bits in{};
+
+        static Bits rotateUp(const Bits& bits, int n);
+        static Bits rotateDown(const Bits& bits, int n);
+        static void set(Bits& bits, int position) {
+            assert(position >= 1 && position <= kMaxWordLength && "word is too long for a gluing key");
+            bits[(position - 1) / 64] |= uint64_t(1) << ((position - 1) % 64);
+        }
+    };
+
+    // Gluing key -> indices of the graphs that contain it. Open addressing with linear probing
+    // over a power-of-two slot array; entries stay in insertion order, which is also the order
+    // of the LP rows built from them.
+    class GluingRestrictions {
+    public:
+        typedef std::pair<GluingKey, std::vector<int>> Entry;
+
+        std::vector<int>& operator[](const GluingKey& key);
+        int indexOf(const GluingKey& key) const; // -1 if absent
+        const Entry& entry(int index) const { return entries[index]; }
+        size_t size() const { return entries.size(); }
+        std::vector<Entry>::const_iterator begin() const { return entries.begin(); }
+        std::vector<Entry>::const_iterator end() const { return entries.end(); }
+        std::vector<Entry>::iterator begin() { return entries.begin(); }
+        std::vector<Entry>::iterator end() { return entries.end(); }
+
+    private:
+        std::vector<Entry> entries;
+        std::vector<int> slots; // entry index + 1, 0 when empty
+
+        size_t slotOf(const GluingKey& key) const; // slot holding key, or the empty slot it would go to
+        void grow();
+    };
+
+    // Everything the linear program needs from the filtered graphs. Graphs are added one at a
+    // time and can be dropped right after, so the graphs themselves never have to be kept.
+    struct LinearProgramData {
+        std::vector<double> objective;            // one coefficient per graph
+        std::vector<int> first_letter_indices;    // graphs containing the edge at position 1
+        GluingRestrictions gluing_restrictions;
+
+        size_t numGraphs() const { return objective.size(); }
+        void addGraph(const WhiteheadGraph& graph);
+        void append(LinearProgramData&& other); // other's graphs are renumbered after ours
+    };
+
     // Declaration of functions from degree_equation.cpp
+    bool hasFirstLetterEdge(const WhiteheadGraph& graph);
+
     std::vector<int> findGraphsWithFirstLetterEdge(const std::vector<WhiteheadGraph>& graphs);
 
+    // Declaration of functions from gluing_equations.cpp
+    std::vector<GluingKey> getGluingKeys(const WhiteheadGraph& graph);
+
     std::vector<std::pair<std::vector<int>, std::vector<int>>> getGluingEquations(const std::vector<WhiteheadGraph> & graphs, int n, StableInvariant& invariant);
 
+    // row_keys, if given, receives the key on the first side of every returned pair
+    std::vector<std::pair<std::vector<int>, std::vector<int>>> getGluingEquations(const LinearProgramData& data, int n, std::vector<GluingKey>* row_keys = nullptr);
+
+    // Declaration of functions from objective_function.cpp
+    double getObjectiveCoefficient(const WhiteheadGraph& graph);
+
+    double getObjectiveUpperBound(const WhiteheadGraph& subgraph); // over all unfoldings of the subgraph
+
     const std::vector<double> getObjective(const std::vector<WhiteheadGraph> & graphs);
 
 }
 
-std::pair<double, std::vector<double>> getLinearProgramSolutionAndMinimizer(std::vector<double> objective_coeffs, std::vector<std::pair<std::vector<int>, std::vector<int>>> constraint_pairs, std::vector<int> degree_equation);
+// A column of the column-generation master LP: the best valid unfolding of one subgraph
+struct GeneratedColumn {
+    int subgraph;
+    uint64_t unfolding;
+    double objective;
+    double value;
+};
+
+struct ColumnGenerationResult {
+    double objective = -1; // -1 if the LP is infeasible or unbounded
+    std::vector<GeneratedColumn> columns;
+    int rows = 0;
+    int rounds = 0;
+    uint64_t subgraphs_unfolded = 0;
+};
+
+// Declaration of functions from column_generation.cpp
+ColumnGenerationResult solveByColumnGeneration(const std::vector<WhiteheadGraph>& validSubgraphs, int n, StableInvariant& invariant, bool unfold, int threads = 1, Exact::Optimum* exact = nullptr);
+
+// Gluing rows in compressed sparse row form: row i holds the entries start[i] .. start[i+1]-1,
+// with at most one entry per column
+struct SparseRows {
+    std::vector<int> start = {0};
+    std::vector<int> column;
+    std::vector<double> value;
+    std::vector<int> origin; // index of the gluing pair each row was built from
+
+    int size() const { return start.size() - 1; }
+};
+
+// Declaration of functions from presolve.cpp
+
+// The LP left after presolve, over the surviving columns only; original_column maps each of
+// them back to its index in the LP that was presolved
+struct PresolvedLinearProgram {
+    std::vector<double> objective;
+    SparseRows gluing_rows;
+    std::vector<int> degree_equation;
+    std::vector<int> original_column;
+    bool infeasible = false;  // every graph of the degree row is forced to zero
+
+    std::vector<int> row_sign;                     // +-1: gluing row i is row_sign[i] times its origin
+    std::vector<std::pair<int, int>> forcing_rows; // (assembled row, sign of the graphs it forced), in order
+
+    int original_rows = 0;    // non-empty rows, degree row included
+    int original_columns = 0;
+    int forced_zero_columns = 0;
+    int duplicate_rows = 0;
+
+    int rows() const { return gluing_rows.size() + 1; }
+    int columns() const { return objective.size(); }
+    // A solution of the presolved LP as a solution of the original one
+    std::vector<double> expandSolution(const std::vector<double>& solution) const;
+    // Duals of the presolved LP (degree row first) as duals of the original one: entry 0 for
+    // the degree row and entry i+1 for gluing pair i. Forcing rows get duals that keep the
+    // reduced costs of the columns they removed nonpositive.
+    std::vector<double> expandDuals(const std::vector<double>& duals, const std::vector<double>& objective_coeffs, const std::vector<std::pair<std::vector<int>, std::vector<int>>>& constraint_pairs, const std::vector<int>& degree_equation) const;
+};
+
+PresolvedLinearProgram presolveLinearProgram(const std::vector<double>& objective_coeffs, const std::vector<std::pair<std::vector<int>, std::vector<int>>>& constraint_pairs, const std::vector<int>& degree_equation);
+
+// Declaration of functions from lp_solver.cpp
+
+// Turns gluing pairs into sparse rows: graphs on the first side add 1 to their column, graphs
+// on the second side subtract 1. Columns that cancel and rows left empty are dropped. Linear
+// in the number of entries.
+SparseRows assembleGluingRows(const std::vector<std::pair<std::vector<int>, std::vector<int>>>& constraint_pairs, size_t numVars);
+
+
+// Keeps one LP backend and the last model alive between solves of the stable invariant LP
+// (max c x s.t. gluing rows = 0, degree row = 1, x >= 0). A new LP is diffed against the
+// previous one column by column, so a backend can rewrite only the changed columns and start
+// from the previous basis; when most columns differ it reloads from scratch instead.
+class LinearProgramSolverContext {
+public:
+    struct Timing {
+        double setup_seconds = 0;  // building the columns and loading them into the backend
+        double solve_seconds = 0;  // the backend's solve and reading the solution back
+        bool warm_start = false;   // the solve started from the previous basis
+        int rows = 0;
+        int columns = 0;
+        int rewritten_columns = 0; // columns loaded or changed by this call
+        LpBackendKind backend = LpBackendKind::GLPK_PRIMAL;
+        bool delegated = false;    // the backend handed the LP on, see LpBackend::Solution
+    };
+
+    LinearProgramSolverContext() = default;
+    ~LinearProgramSolverContext();
+    LinearProgramSolverContext(const LinearProgramSolverContext&) = delete;
+    LinearProgramSolverContext& operator=(const LinearProgramSolverContext&) = delete;
+
+    std::pair<double, std::vector<double>> solve(const std::vector<double>& objective_coeffs, const SparseRows& gluing_rows, const std::vector<int>& degree_equation, Exact::Optimum* exact = nullptr);
+    std::pair<double, std::vector<double>> solve(const std::vector<double>& objective_coeffs, const std::vector<std::pair<std::vector<int>, std::vector<int>>>& constraint_pairs, const std::vector<int>& degree_equation, Exact::Optimum* exact = nullptr);
+
+    const Timing& lastTiming() const { return timing; }
+    const std::vector<double>& lastRowDuals() const { return row_duals; } // degree row first; empty unless optimal
+    void reset(); // drops the backend's problem; the next solve starts cold
+    void setBackend(LpBackendKind kind); // takes effect, cold, at the next solve if it differs
+    bool writeModel(const std::string& path, ModelFormat format) const; // the last LP loaded
+
+    // The context of the calling thread; GLPK problems must not cross threads
+    static LinearProgramSolverContext& forThisThread();
+
+private:
+    LpBackendKind kind = LpBackendKind::GLPK_PRIMAL;
+    std::unique_ptr<LpBackend> backend;
+    LinearProgramModel model;
+    std::vector<LinearProgramModel::SparseColumn> previous_columns; // of the model loaded before
+    ModelDelta delta;
+    Timing timing;
+    std::vector<double> row_duals;
+
+    void buildModel(const std::vector<double>& objective_coeffs, const SparseRows& gluing_rows, const std::vector<int>& degree_equation);
+};
+
+// Solves on the calling thread's LinearProgramSolverContext
+std::pair<double, std::vector<double>> getLinearProgramSolutionAndMinimizer(std::vector<double> objective_coeffs, std::vector<std::pair<std::vector<int>, std::vector<int>>> constraint_pairs, std::vector<int> degree_equation, Exact::Optimum* exact = nullptr);
+std::pair<double, std::vector<double>> getLinearProgramSolutionAndMinimizer(const std::vector<double>& objective_coeffs, const SparseRows& gluing_rows, const std::vector<int>& degree_equation, Exact::Optimum* exact = nullptr);
+
+bool certifyExactOptimum(glp_prob *lp, Exact::Optimum& exact);
+
+void releaseLinearProgramSolverThreadState();
 
 #endif // linear_program_construction_h
@@ -0,0 +1,94 @@
+#ifndef lp_backend_h
+#define lp_backend_h
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <utility>
+#include "rational.h"
+
+// LP engines behind LinearProgramSolverContext
+enum class LpBackendKind {
+    GLPK_PRIMAL = 0,
+    GLPK_DUAL = 1,
+    GLPK_INTERIOR = 2,
+    SPARSE_SIMPLEX = 3, // built-in revised simplex, see sparse_simplex.cpp
+    RATIO_CYCLE = 4     // experimental ratio cycle search, see ratio_cycle.cpp
+};
+
+const char* lpBackendName(LpBackendKind kind);
+bool parseLpBackend(const std::string& name, LpBackendKind& kind);
+const std::vector<LpBackendKind>& allLpBackends();
+
+// An LP as every backend sees it: max c x s.t. A x = b, x >= 0, stored by column. For the
+// stable invariant LP row 1 is the degree row (b = 1) and the gluing rows follow (b = 0).
+struct LinearProgramModel {
+    typedef std::vector<std::pair<int, double>> SparseColumn; // (row, coefficient), 1-based rows
+
+    std::vector<double> objective;
+    std::vector<SparseColumn> columns;
+    std::vector<double> rhs; // rhs[i - 1] is the right-hand side of row i
+
+    int numRows() const { return rhs.size(); }
+    int numColumns() const { return columns.size(); }
+};
+
+// How a model differs from the one loaded before it. Columns past previous_columns are new.
+struct ModelDelta {
+    int previous_rows = 0;
+    int previous_columns = 0;
+    std::vector<char> changed; // per column of the new model
+    int unchanged = 0;
+};
+
+class LpBackend {
+public:
+    struct Solution {
+        bool optimal = false;
+        double objective = -1;
+        std::vector<double> x;
+        std::vector<double> row_duals; // y, so that the reduced costs are c - y A
+        bool restarted = false;        // the basis kept by load() had to be dropped
+        bool delegated = false;        // solved by another backend the first could not handle
+    };
+
+    virtual ~LpBackend() = default;
+
+    // Takes the model to solve next, which must stay alive until the next load; returns
+    // whether the next solve starts from the previous basis. rewritten_columns counts the
+    // columns the backend had to (re)load.
+    virtual bool load(const LinearProgramModel& model, const ModelDelta& delta, int& rewritten_columns) = 0;
+    virtual Solution solve() = 0;
+    // Certifies an optimal solution exactly; may replace its duals with exact ones
+    virtual void certify(const LinearProgramModel& model, Solution& solution, Exact::Optimum& exact);
+    virtual void reset() = 0; // forget the previous model and basis
+};
+
+std::unique_ptr<LpBackend> makeLpBackend(LpBackendKind kind);
+std::unique_ptr<LpBackend> makeSparseSimplexBackend();
+std::unique_ptr<LpBackend> makeRatioCycleBackend();
+
+// Checks an optimal solution in exact arithmetic: the rationalized x and y must satisfy
+// A x = b, x >= 0, c_j - y A_j <= 0 and c x = b y, which proves c x is the optimal value
+bool checkExactOptimum(const LinearProgramModel& model, const std::vector<double>& x, const std::vector<double>& y, Exact::Rational& objective);
+
+// Model files for offline LP experiments
+enum class ModelFormat {
+    MPS,      // free MPS
+    CPLEX_LP
+};
+
+bool writeLinearProgramModel(const std::string& path, ModelFormat format, const LinearProgramModel& model);
+bool readLinearProgramModel(const std::string& path, ModelFormat format, LinearProgramModel& model);
+
+struct ModelReplay {
+    bool optimal = false;
+    double objective = -1;
+    double seconds = 0; // the solve alone, not loading the model
+    bool delegated = false;
+};
+
+// Solves a model once on a fresh backend
+ModelReplay replayLinearProgramModel(const LinearProgramModel& model, LpBackendKind kind);
+
+#endif
@@ -2,6 +2,8 @@
 #include <vector>
 #include <glpk.h>
 #include "linear_program_construction.h"
+#include "rational.h"
+#include <chrono>
 
 
 #include <glpk.h>
@@ -70,109 +72,515 @@ void print_glp_matrix(glp_prob *lp, int numVars, int numConstraints) {
     }
 }
 
-// Function to remove intersection elements from both vectors
-void remove_intersection_from_both(std::vector<int>& v1, std::vector<int>& v2) {
-    // Step 1: Create a lambda to remove elements from a vector based on the other vector
-    auto remove_elements = [](std::vector<int>& vec, const std::vector<int>& other_vec) {
-        vec.erase(std::remove_if(vec.begin(), vec.end(),
-                                 [&other_vec](int element) {
-                                     return std::find(other_vec.begin(), other_vec.end(), element) != other_vec.end();
-                                 }),
-                  vec.end());
+SparseRows assembleGluingRows(const std::vector<std::pair<std::vector<int>, std::vector<int>>>& constraint_pairs, size_t numVars) {
+    size_t entries = 0;
+    for (const auto& constraint : constraint_pairs) {
+        entries += constraint.first.size() + constraint.second.size();
+    }
+    SparseRows rows;
+    rows.start.reserve(constraint_pairs.size() + 1);
+    rows.column.reserve(entries);
+    rows.value.reserve(entries);
+    rows.origin.reserve(constraint_pairs.size());
+
+    // Net coefficient of each column in the current row; touched lists the columns to write
+    // out and reset, so the scratch array is never cleared as a whole
+    std::vector<double> coefficient(numVars, 0.0);
+    std::vector<int> touched;
+    for (size_t i = 0; i < constraint_pairs.size(); ++i) {
+        const auto& [pos, neg] = constraint_pairs[i];
+        touched.clear();
+        for (int j : pos) {
+            if (coefficient[j] == 0) touched.push_back(j);
+            coefficient[j] += 1.0;
+        }
+        for (int j : neg) {
+            if (coefficient[j] == 0) touched.push_back(j);
+            coefficient[j] -= 1.0;
+        }
+        for (int j : touched) {
+            if (coefficient[j] == 0) continue; // cancelled, or already written
+            rows.column.push_back(j);
+            rows.value.push_back(coefficient[j]);
+            coefficient[j] = 0;
+        }
+        if (static_cast<int>(rows.column.size()) == rows.start.back()) continue;
+        rows.start.push_back(rows.column.size());
+        rows.origin.push_back(i);
+    }
+    return rows;
+}
+
+// Largest denominator accepted when turning the solvers' doubles back into fractions
+static const int64_t kMaxExactDenominator = 1000000;
+
+bool checkExactOptimum(const LinearProgramModel& model, const std::vector<double>& x, const std::vector<double>& y, Exact::Rational& objective) {
+    const int numRows = model.numRows();
+    const int numCols = model.numColumns();
+    if (static_cast<int>(x.size()) != numCols || static_cast<int>(y.size()) != numRows) return false;
+
+    std::vector<Exact::Rational> rational_y(numRows);
+    std::vector<Exact::Rational> activity(numRows);
+    Exact::Rational dual_value;
+    for (int i = 0; i < numRows; ++i) {
+        rational_y[i] = Exact::rationalize(y[i], kMaxExactDenominator);
+        dual_value += Exact::rationalize(model.rhs[i], kMaxExactDenominator) * rational_y[i];
+    }
+
+    Exact::Rational primal_value;
+    for (int j = 0; j < numCols; ++j) {
+        const Exact::Rational x_j = Exact::rationalize(x[j], kMaxExactDenominator);
+        if (x_j.sign() < 0) return false;
+        Exact::Rational reduced_cost = Exact::rationalize(model.objective[j], kMaxExactDenominator);
+        primal_value += reduced_cost * x_j;
+        for (const auto& [row, coefficient] : model.columns[j]) {
+            const Exact::Rational a = Exact::rationalize(coefficient, kMaxExactDenominator);
+            activity[row - 1] += a * x_j;
+            reduced_cost = reduced_cost - a * rational_y[row - 1];
+        }
+        if (reduced_cost.sign() > 0 || reduced_cost.overflowed()) return false;
+    }
+
+    for (int i = 0; i < numRows; ++i) {
+        if (activity[i] != Exact::rationalize(model.rhs[i], kMaxExactDenominator) || activity[i].overflowed()) return false;
+    }
+    if (primal_value != dual_value || primal_value.overflowed() || dual_value.overflowed()) return false;
+    objective = primal_value;
+    return true;
+}
+
+// The model held by a GLPK problem; false unless it maximizes over fixed rows and x >= 0
+static bool extractModel(glp_prob *lp, LinearProgramModel& model) {
+    if (glp_get_obj_dir(lp) != GLP_MAX) return false;
+    const int numRows = glp_get_num_rows(lp);
+    const int numCols = glp_get_num_cols(lp);
+    model.rhs.resize(numRows);
+    for (int i = 1; i <= numRows; ++i) {
+        if (glp_get_row_type(lp, i) != GLP_FX) return false;
+        model.rhs[i - 1] = glp_get_row_lb(lp, i);
+    }
+    model.objective.resize(numCols);
+    model.columns.assign(numCols, {});
+    std::vector<int> ind(numRows + 1);
+    std::vector<double> val(numRows + 1);
+    for (int j = 1; j <= numCols; ++j) {
+        if (glp_get_col_type(lp, j) != GLP_LO || glp_get_col_lb(lp, j) != 0) return false;
+        model.objective[j - 1] = glp_get_obj_coef(lp, j);
+        const int len = glp_get_mat_col(lp, j, ind.data(), val.data());
+        for (int k = 1; k <= len; ++k) model.columns[j - 1].emplace_back(ind[k], val[k]);
+    }
+    return true;
+}
+
+static void loadModel(glp_prob *lp, const LinearProgramModel& model) {
+    glp_erase_prob(lp);
+    glp_set_obj_dir(lp, GLP_MAX);
+    if (model.numRows() > 0) glp_add_rows(lp, model.numRows());
+    if (model.numColumns() > 0) glp_add_cols(lp, model.numColumns());
+    for (int i = 1; i <= model.numRows(); ++i) {
+        glp_set_row_bnds(lp, i, GLP_FX, model.rhs[i - 1], model.rhs[i - 1]);
+    }
+    std::vector<int> ind;
+    std::vector<double> val;
+    for (int j = 1; j <= model.numColumns(); ++j) {
+        ind.assign(1, 0);
+        val.assign(1, 0.0);
+        for (const auto& [row, coefficient] : model.columns[j - 1]) {
+            ind.push_back(row);
+            val.push_back(coefficient);
+        }
+        glp_set_mat_col(lp, j, ind.size() - 1, ind.data(), val.data());
+        glp_set_col_bnds(lp, j, GLP_LO, 0.0, 0.0);
+        glp_set_obj_coef(lp, j, model.objective[j - 1]);
+    }
+}
+
+static void readSimplexSolution(glp_prob *lp, std::vector<double>& x, std::vector<double>& y) {
+    x.resize(glp_get_num_cols(lp));
+    for (size_t j = 0; j < x.size(); ++j) x[j] = glp_get_col_prim(lp, j + 1);
+    y.resize(glp_get_num_rows(lp));
+    for (size_t i = 0; i < y.size(); ++i) y[i] = glp_get_row_dual(lp, i + 1);
+}
+
+// Re-solves lp with GLPK's exact simplex from its current basis, which typically needs no
+// pivots when that basis is optimal, and checks the exact solution. The duals of the exact
+// pass replace the floating-point ones.
+static bool exactPass(glp_prob *lp, const LinearProgramModel& model, LpBackend::Solution& solution, Exact::Rational& objective) {
+    glp_smcp parm;
+    glp_init_smcp(&parm);
+    parm.msg_lev = GLP_MSG_OFF;
+    if (glp_exact(lp, &parm) != 0 || glp_get_status(lp) != GLP_OPT) return false;
+    std::vector<double> x;
+    readSimplexSolution(lp, x, solution.row_duals);
+    return checkExactOptimum(model, x, solution.row_duals, objective);
+}
+
+// Certifies the optimum found in floating point. If rounding noise defeats the check, the
+// exact simplex is run on a copy of the model from scratch.
+void LpBackend::certify(const LinearProgramModel& model, Solution& solution, Exact::Optimum& exact) {
+    const auto start = std::chrono::steady_clock::now();
+    exact.certified = checkExactOptimum(model, solution.x, solution.row_duals, exact.objective);
+    if (!exact.certified) {
+        glp_prob *lp = glp_create_prob();
+        loadModel(lp, model);
+        exact.certified = exactPass(lp, model, solution, exact.objective);
+        glp_delete_prob(lp);
+    }
+    exact.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Certifies the optimum held by lp, restarting the exact simplex from its optimal basis if
+// rounding noise defeats the first check
+bool certifyExactOptimum(glp_prob *lp, Exact::Optimum& exact) {
+    const auto start = std::chrono::steady_clock::now();
+    LinearProgramModel model;
+    exact.certified = false;
+    if (extractModel(lp, model)) {
+        LpBackend::Solution solution;
+        readSimplexSolution(lp, solution.x, solution.row_duals);
+        exact.certified = checkExactOptimum(model, solution.x, solution.row_duals, exact.objective) ||
+                          exactPass(lp, model, solution, exact.objective);
+    }
+    exact.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return exact.certified;
+}
+
+namespace {
+    // GLPK's primal or dual simplex, or its interior-point method, on one problem that is kept
+    // between solves and edited in place
+    class GlpkBackend : public LpBackend {
+    public:
+        explicit GlpkBackend(LpBackendKind kind_) : kind(kind_) {}
+        ~GlpkBackend() override { reset(); }
+
+        bool load(const LinearProgramModel& model, const ModelDelta& delta, int& rewritten_columns) override;
+        Solution solve() override;
+        void certify(const LinearProgramModel& model, Solution& solution, Exact::Optimum& exact) override;
+        void reset() override;
+
+    private:
+        LpBackendKind kind;
+        glp_prob *lp = nullptr;
+        int loaded_rows = 0;
+        int loaded_columns = 0;
+        bool warm = false;
+        std::vector<int> ind; // scratch buffers, kept for their capacity
+        std::vector<double> val;
+
+        void setColumn(int j, const LinearProgramModel::SparseColumn& column);
     };
 
-    // Step 2: Find and remove elements that are common in both vectors
-    std::vector<int> intersection;
-    std::set_intersection(v1.begin(), v1.end(), v2.begin(), v2.end(), std::back_inserter(intersection));
+    void GlpkBackend::reset() {
+        if (lp) glp_delete_prob(lp);
+        lp = nullptr;
+        loaded_rows = 0;
+        loaded_columns = 0;
+    }
+
+    void GlpkBackend::setColumn(int j, const LinearProgramModel::SparseColumn& column) {
+        ind.assign(1, 0);
+        val.assign(1, 0.0);
+        for (const auto& [row, coefficient] : column) {
+            ind.push_back(row);
+            val.push_back(coefficient);
+        }
+        glp_set_mat_col(lp, j, column.size(), ind.data(), val.data());
+    }
+
+    bool GlpkBackend::load(const LinearProgramModel& model, const ModelDelta& delta, int& rewritten_columns) {
+        const int numRows = model.numRows();
+        const int numVars = model.numColumns();
+
+        // Step 1: A different LP altogether is reloaded; the old basis would only slow it down
+        const bool incremental = lp && loaded_rows > 0 && 2 * delta.unchanged >= numVars;
+        if (!incremental) {
+            if (!lp) lp = glp_create_prob();
+            else glp_erase_prob(lp);
+            glp_set_obj_dir(lp, GLP_MAX);
+            glp_add_rows(lp, numRows);
+            glp_add_cols(lp, numVars);
+            for (int j = 1; j <= numVars; ++j) {
+                glp_set_col_bnds(lp, j, GLP_LO, 0.0, 0.0);
+                setColumn(j, model.columns[j - 1]);
+            }
+            rewritten_columns = numVars;
+        } else {
+            // Step 2: Resize at the end; new rows start basic and new columns at their bound,
+            // so the basis stays valid unless a basic column or nonbasic row is removed
+            if (numRows > loaded_rows) {
+                glp_add_rows(lp, numRows - loaded_rows);
+            } else if (numRows < loaded_rows) {
+                std::vector<int> num = {0};
+                for (int i = numRows + 1; i <= loaded_rows; ++i) num.push_back(i);
+                glp_del_rows(lp, num.size() - 1, num.data());
+            }
+            if (numVars > loaded_columns) {
+                glp_add_cols(lp, numVars - loaded_columns);
+            } else if (numVars < loaded_columns) {
+                std::vector<int> num = {0};
+                for (int j = numVars + 1; j <= loaded_columns; ++j) num.push_back(j);
+                glp_del_cols(lp, num.size() - 1, num.data());
+            }
+            // Step 3: Rewrite only the columns that changed
+            rewritten_columns = 0;
+            for (int j = 1; j <= numVars; ++j) {
+                if (!delta.changed[j - 1]) continue;
+                if (j > delta.previous_columns) glp_set_col_bnds(lp, j, GLP_LO, 0.0, 0.0);
+                setColumn(j, model.columns[j - 1]);
+                rewritten_columns++;
+            }
+        }
+        for (int i = 1; i <= numRows; ++i) {
+            glp_set_row_bnds(lp, i, GLP_FX, model.rhs[i - 1], model.rhs[i - 1]); // Equality constraints
+        }
+        for (int j = 1; j <= numVars; ++j) {
+            glp_set_obj_coef(lp, j, model.objective[j - 1]);
+        }
+
+        loaded_rows = numRows;
+        loaded_columns = numVars;
+        // The interior-point method has no use for a basis
+        warm = incremental && kind != LpBackendKind::GLPK_INTERIOR;
+        return warm;
+    }
+
+    LpBackend::Solution GlpkBackend::solve() {
+        Solution solution;
+        glp_term_out(GLP_OFF);
+        if (kind == LpBackendKind::GLPK_INTERIOR) {
+            glp_iptcp parm;
+            glp_init_iptcp(&parm);
+            parm.msg_lev = GLP_MSG_OFF;
+            solution.optimal = glp_interior(lp, &parm) == 0 && glp_ipt_status(lp) == GLP_OPT;
+            if (!solution.optimal) return solution;
+            solution.objective = glp_ipt_obj_val(lp);
+            solution.x.resize(loaded_columns);
+            for (int j = 1; j <= loaded_columns; ++j) solution.x[j - 1] = glp_ipt_col_prim(lp, j);
+            solution.row_duals.resize(loaded_rows);
+            for (int i = 1; i <= loaded_rows; ++i) solution.row_duals[i - 1] = glp_ipt_row_dual(lp, i);
+            return solution;
+        }
+
+        glp_smcp parm;
+        glp_init_smcp(&parm);
+        parm.msg_lev = GLP_MSG_OFF;
+        parm.meth = kind == LpBackendKind::GLPK_DUAL ? GLP_DUALP : GLP_PRIMAL;
 
-    // Step 3: Remove the intersection from both vectors
-    remove_elements(v1, intersection);
-    remove_elements(v2, intersection);
+        // Solve the linear program; a warm basis that edits made invalid or singular is replaced
+        int status = glp_simplex(lp, &parm);
+        if (warm && (status == GLP_EBADB || status == GLP_ESING || status == GLP_ECOND)) {
+            solution.restarted = true;
+            glp_adv_basis(lp, 0);
+            status = glp_simplex(lp, &parm);
+        }
+        solution.optimal = status == 0 && glp_get_status(lp) == GLP_OPT;
+        if (!solution.optimal) {
+            // Keep the matrix, but do not warm-start the next solve from a failed basis
+            glp_std_basis(lp);
+            return solution;
+        }
+        solution.objective = glp_get_obj_val(lp);
+        readSimplexSolution(lp, solution.x, solution.row_duals);
+        return solution;
+    }
+
+    void GlpkBackend::certify(const LinearProgramModel& model, Solution& solution, Exact::Optimum& exact) {
+        const auto start = std::chrono::steady_clock::now();
+        exact.certified = checkExactOptimum(model, solution.x, solution.row_duals, exact.objective);
+        if (!exact.certified) {
+            // The interior point leaves no optimal basis to restart from
+            if (kind == LpBackendKind::GLPK_INTERIOR) glp_std_basis(lp);
+            exact.certified = exactPass(lp, model, solution, exact.objective);
+        }
+        exact.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
 }
 
-std::pair<double, std::vector<double>> getLinearProgramSolutionAndMinimizer(std::vector<double> objective_coeffs, std::vector<std::pair<std::vector<int>, std::vector<int>>> constraint_pairs, std::vector<int> degree_equation) {
-    // Create the GLPK problem object
-    glp_prob *lp = glp_create_prob();
-    glp_set_obj_dir(lp, GLP_MAX); // Set the objective to maximize
-
-    // Dynamic vectors for coefficients and constraints
-    std::vector<double> rhs;
-    rhs.reserve(constraint_pairs.size());
-    // Load the constraint matrix
-    std::vector<int> ia = {0}; // Row indices
-    std::vector<int> ja = {0}; // Column indices
-    std::vector<double> ar = {0.0}; // Values
-    int constraints_used = 0;
-    for (int i=0; i<constraint_pairs.size(); i++){
-        auto& pos = constraint_pairs[i].first;
-        auto& neg = constraint_pairs[i].second;
-        remove_intersection_from_both(pos, neg);
-        for (int i=0; i<pos.size(); i++){
-            pos[i]++;
-        }
-        for (int i=0; i<neg.size(); i++){
-            neg[i]++;
-        }
-        if (neg.size() + pos.size() == 0) { continue; }
-        constraints_used++;
-        ar.insert(ar.end(), pos.size(), 1.0);
-        ar.insert(ar.end(), neg.size(), -1.0);
-        rhs.push_back(0.0);
-        ia.insert(ia.end(), pos.size()+neg.size(), constraints_used);
-        ja.insert(ja.end(), pos.begin(), pos.end());
-        ja.insert(ja.end(), neg.begin(), neg.end());
-    }
-    for (int i=0; i<degree_equation.size(); i++){
-        degree_equation[i]++;
-    }
-    ia.insert(ia.end(), degree_equation.size(), constraints_used + 1);
-    ja.insert(ja.end(), degree_equation.begin(), degree_equation.end());
-    ar.insert(ar.end(), degree_equation.size(), 1.0);
-    // Define the number of variables and constraints
-    int numVars = objective_coeffs.size();
-    int numConstraints = constraints_used;
-
-    // Add variables
-    glp_add_cols(lp, numVars);
-    for (int i = 1; i <= numVars; ++i) {
-        glp_set_col_bnds(lp, i, GLP_LO, 0.0, 0.0); // Lower bound: 0
-        glp_set_obj_coef(lp, i, objective_coeffs[i - 1]); // Set objective coefficients
+const char* lpBackendName(LpBackendKind kind) {
+    switch (kind) {
+        case LpBackendKind::GLPK_PRIMAL: return "glpk-primal";
+        case LpBackendKind::GLPK_DUAL: return "glpk-dual";
+        case LpBackendKind::GLPK_INTERIOR: return "glpk-interior";
+        case LpBackendKind::SPARSE_SIMPLEX: return "sparse-simplex";
+        case LpBackendKind::RATIO_CYCLE: return "ratio-cycle";
     }
+    return "unknown";
+}
 
-    // Add constraints
-    glp_add_rows(lp, numConstraints + 1); // +1 for degree equation
-    for (int i = 1; i <= numConstraints; ++i) {
-        glp_set_row_bnds(lp, i, GLP_FX, rhs[i - 1], rhs[i - 1]); // Equality constraints
+bool parseLpBackend(const std::string& name, LpBackendKind& kind) {
+    for (LpBackendKind candidate : allLpBackends()) {
+        if (name == lpBackendName(candidate)) {
+            kind = candidate;
+            return true;
+        }
     }
-    glp_set_row_bnds(lp, numConstraints + 1, GLP_FX, 1.0, 1.0); // Equality constraint for dgree
+    return false;
+}
 
-    // Load the matrix into GLPK
-    glp_load_matrix(lp, ia.size() - 1, ia.data(), ja.data(), ar.data());
+const std::vector<LpBackendKind>& allLpBackends() {
+    static const std::vector<LpBackendKind> kinds = {LpBackendKind::GLPK_PRIMAL, LpBackendKind::GLPK_DUAL,
+                                                     LpBackendKind::GLPK_INTERIOR, LpBackendKind::SPARSE_SIMPLEX,
+                                                     LpBackendKind::RATIO_CYCLE};
+    return kinds;
+}
 
-    glp_term_out(GLP_OFF);
+std::unique_ptr<LpBackend> makeLpBackend(LpBackendKind kind) {
+    if (kind == LpBackendKind::SPARSE_SIMPLEX) return makeSparseSimplexBackend();
+    if (kind == LpBackendKind::RATIO_CYCLE) return makeRatioCycleBackend();
+    return std::make_unique<GlpkBackend>(kind);
+}
+
+LinearProgramSolverContext::~LinearProgramSolverContext() {
+    reset();
+}
+
+void LinearProgramSolverContext::reset() {
+    if (backend) backend->reset();
+    previous_columns.clear();
+    model = LinearProgramModel();
+}
+
+void LinearProgramSolverContext::setBackend(LpBackendKind kind_) {
+    if (backend && kind_ == kind) return;
+    reset();
+    kind = kind_;
+    backend = makeLpBackend(kind);
+}
+
+LinearProgramSolverContext& LinearProgramSolverContext::forThisThread() {
+    thread_local LinearProgramSolverContext context;
+    return context;
+}
+
+// Column-major form of the LP: the degree row first, then the gluing rows in order. With the
+// degree row in front, adding or dropping gluing rows at the end leaves every other column
+// untouched. The previous columns are kept to diff against.
+void LinearProgramSolverContext::buildModel(const std::vector<double>& objective_coeffs, const SparseRows& gluing_rows, const std::vector<int>& degree_equation) {
+    const size_t numVars = objective_coeffs.size();
+    delta.previous_rows = model.numRows();
+    delta.previous_columns = model.numColumns();
+    previous_columns.swap(model.columns);
+
+    model.objective = objective_coeffs;
+    model.columns.resize(numVars);
+    for (auto& column : model.columns) column.clear();
+    for (int j : degree_equation) {
+        model.columns[j].emplace_back(1, 1.0);
+    }
+    for (int i = 0; i < gluing_rows.size(); ++i) {
+        for (int k = gluing_rows.start[i]; k < gluing_rows.start[i + 1]; ++k) {
+            model.columns[gluing_rows.column[k]].emplace_back(i + 2, gluing_rows.value[k]);
+        }
+    }
+    model.rhs.assign(gluing_rows.size() + 1, 0.0);
+    model.rhs[0] = 1.0;
+
+    delta.changed.assign(numVars, 1);
+    delta.unchanged = 0;
+    const size_t common = std::min(numVars, previous_columns.size());
+    for (size_t j = 0; j < common; ++j) {
+        if (model.columns[j] != previous_columns[j]) continue;
+        delta.changed[j] = 0;
+        delta.unchanged++;
+    }
+    timing.rows = model.numRows();
+    timing.columns = numVars;
+}
+
+bool LinearProgramSolverContext::writeModel(const std::string& path, ModelFormat format) const {
+    if (model.numRows() == 0) return false;
+    return writeLinearProgramModel(path, format, model);
+}
 
-    // Solve the linear program
-    int status = glp_simplex(lp, nullptr);
-    int solution_status = glp_get_status(lp);
+std::pair<double, std::vector<double>> LinearProgramSolverContext::solve(const std::vector<double>& objective_coeffs, const std::vector<std::pair<std::vector<int>, std::vector<int>>>& constraint_pairs, const std::vector<int>& degree_equation, Exact::Optimum* exact) {
+    const auto start = std::chrono::steady_clock::now();
+    const SparseRows gluing_rows = assembleGluingRows(constraint_pairs, objective_coeffs.size());
+    const double assembly_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    auto result = solve(objective_coeffs, gluing_rows, degree_equation, exact);
+    timing.setup_seconds += assembly_seconds;
+    return result;
+}
+
+std::pair<double, std::vector<double>> LinearProgramSolverContext::solve(const std::vector<double>& objective_coeffs, const SparseRows& gluing_rows, const std::vector<int>& degree_equation, Exact::Optimum* exact) {
+    const auto start = std::chrono::steady_clock::now();
+    if (!backend) backend = makeLpBackend(kind);
+    buildModel(objective_coeffs, gluing_rows, degree_equation);
+    timing.backend = kind;
+    timing.warm_start = backend->load(model, delta, timing.rewritten_columns);
+    const auto loaded = std::chrono::steady_clock::now();
+    timing.setup_seconds = std::chrono::duration<double>(loaded - start).count();
+
+    LpBackend::Solution result = backend->solve();
+    if (result.restarted) timing.warm_start = false;
+    timing.delegated = result.delegated;
 
-    
     // Output results
     std::vector<double> solution;
-    double obj_value;
-    if (status == 0 && solution_status == GLP_OPT){
-        obj_value = glp_get_obj_val(lp);
+    double obj_value = -1;
+    if (result.optimal) {
+        obj_value = result.objective;
         const bool verbose = false;
         if (verbose) std::cout << "Objective value: " << obj_value << std::endl;
-        for (int i = 1; i <= numVars; ++i) {
-            solution.push_back(glp_get_col_prim(lp, i));
-            if (verbose) std::cout << "Graph x" << i << " coefficient: " << solution[i-1] << std::endl;
+        solution = result.x;
+        for (size_t i = 0; verbose && i < solution.size(); ++i) {
+            std::cout << "Graph x" << i + 1 << " coefficient: " << solution[i] << std::endl;
         }
-    } else {
-        obj_value = -1;
     }
+    timing.solve_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - loaded).count();
+    if (result.optimal && exact) backend->certify(model, result, *exact);
+    // Read after the exact pass, which may have replaced the floating-point duals
+    row_duals.clear();
+    if (result.optimal) row_duals.swap(result.row_duals);
+    return std::make_pair(obj_value, solution);
+}
+
+std::pair<double, std::vector<double>> getLinearProgramSolutionAndMinimizer(std::vector<double> objective_coeffs, std::vector<std::pair<std::vector<int>, std::vector<int>>> constraint_pairs, std::vector<int> degree_equation, Exact::Optimum* exact) {
+    return LinearProgramSolverContext::forThisThread().solve(objective_coeffs, constraint_pairs, degree_equation, exact);
+}
 
-    // Cleanup
+std::pair<double, std::vector<double>> getLinearProgramSolutionAndMinimizer(const std::vector<double>& objective_coeffs, const SparseRows& gluing_rows, const std::vector<int>& degree_equation, Exact::Optimum* exact) {
+    return LinearProgramSolverContext::forThisThread().solve(objective_coeffs, gluing_rows, degree_equation, exact);
+}
+
+bool writeLinearProgramModel(const std::string& path, ModelFormat format, const LinearProgramModel& model) {
+    glp_prob *lp = glp_create_prob();
+    loadModel(lp, model);
+    const int status = format == ModelFormat::MPS ? glp_write_mps(lp, GLP_MPS_FILE, nullptr, path.c_str())
+                                                  : glp_write_lp(lp, nullptr, path.c_str());
     glp_delete_prob(lp);
-    return std::make_pair(obj_value, solution);
+    return status == 0;
 }
 
+bool readLinearProgramModel(const std::string& path, ModelFormat format, LinearProgramModel& model) {
+    glp_term_out(GLP_OFF);
+    glp_prob *lp = glp_create_prob();
+    const int status = format == ModelFormat::MPS ? glp_read_mps(lp, GLP_MPS_FILE, nullptr, path.c_str())
+                                                  : glp_read_lp(lp, nullptr, path.c_str());
+    const bool ok = status == 0 && extractModel(lp, model);
+    glp_delete_prob(lp);
+    return ok;
+}
+
+ModelReplay replayLinearProgramModel(const LinearProgramModel& model, LpBackendKind kind) {
+    ModelReplay replay;
+    std::unique_ptr<LpBackend> backend = makeLpBackend(kind);
+    ModelDelta delta;
+    delta.changed.assign(model.numColumns(), 1);
+    int rewritten_columns = 0;
+    backend->load(model, delta, rewritten_columns);
+
+    const auto start = std::chrono::steady_clock::now();
+    const LpBackend::Solution solution = backend->solve();
+    replay.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    replay.optimal = solution.optimal;
+    replay.objective = solution.objective;
+    replay.delegated = solution.delegated;
+    return replay;
+}
+
+// GLPK keeps its environment in thread-local storage; worker threads release it before exiting,
+// after the thread's solver context has dropped its problem
+void releaseLinearProgramSolverThreadState() {
+    LinearProgramSolverContext::forThisThread().reset();
+    glp_free_env();
+}
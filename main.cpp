@@ -1,17 +1,134 @@
 // main.cpp
 #include "runner.h"
 #include "whitehead_automorphisms.h"
+#include "thread_pool.h"
+#include "certificate.h"
+#include "linear_program_construction.h"
 #include <iostream>
 #include <numeric>
 #include <chrono>
+#include <cmath>
+#include <string>
+#include <map>
+#include <set>
 #include <fstream>  // Include for file operations
+#include <filesystem>
+#include <algorithm>
+#include <iomanip>
+
+// Options that may appear anywhere after the mode
+struct CommandLineOptions {
+    int threads = 1;
+    bool has_seed = false;
+    uint64_t seed = 0;
+    size_t cache_size = 4096;
+    bool column_generation = false;
+    std::string certificate_file;
+    bool check_dual = false;
+    std::string lp_export_dir;
+    bool lp_export_cplex = false;
+    bool has_lp_backend = false;
+    LpBackendKind lp_backend = LpBackendKind::GLPK_PRIMAL;
+    double deadline_seconds = 0;
+
+    CalculationOptions calculation(int calculation_threads) const {
+        CalculationOptions options;
+        options.threads = calculation_threads;
+        options.column_generation = column_generation;
+        options.lp_export_dir = lp_export_dir;
+        options.lp_export_cplex = lp_export_cplex;
+        options.lp_backend = lp_backend;
+        options.deadline_seconds = deadline_seconds;
+        return options;
+    }
+};
+
+// Strips "--name value" options (and the "--column-generation" / "--check-dual" flags) out of argv so the positional parsing below is unchanged
+CommandLineOptions extractOptions(int& argc, char* argv[]) {
+    CommandLineOptions options;
+    int kept = 1;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            options.threads = std::stoi(argv[++i]);
+        } else if (arg == "--seed" && i + 1 < argc) {
+            options.seed = std::stoull(argv[++i]);
+            options.has_seed = true;
+        } else if (arg == "--cache-size" && i + 1 < argc) {
+            options.cache_size = std::stoull(argv[++i]);
+        } else if (arg == "--column-generation") {
+            options.column_generation = true;
+        } else if (arg == "--certificate" && i + 1 < argc) {
+            options.certificate_file = argv[++i];
+        } else if (arg == "--check-dual") {
+            options.check_dual = true;
+        } else if (arg == "--export-lp" && i + 1 < argc) {
+            options.lp_export_dir = argv[++i];
+        } else if (arg == "--export-format" && i + 1 < argc) {
+            const std::string format = argv[++i];
+            if (format == "lp" || format == "mps") {
+                options.lp_export_cplex = format == "lp";
+            } else {
+                std::cerr << "Unknown export format '" << format << "', using " << (options.lp_export_cplex ? "lp" : "mps") << std::endl;
+            }
+        } else if (arg == "--deadline" && i + 1 < argc) {
+            options.deadline_seconds = std::stod(argv[++i]);
+        } else if (arg == "--lp-backend" && i + 1 < argc) {
+            if (!parseLpBackend(argv[++i], options.lp_backend)) {
+                std::cerr << "Unknown LP backend '" << argv[i] << "', using " << lpBackendName(options.lp_backend) << std::endl;
+            } else {
+                options.has_lp_backend = true;
+            }
+        } else {
+            argv[kept++] = argv[i];
+        }
+    }
+    argc = kept;
+    return options;
+}
+
+// The in-process objective recorded in an exported model's sidecar
+bool readSidecarValue(const std::string& path, double& value) {
+    std::ifstream in(path);
+    std::string token;
+    while (in >> token) {
+        if (token == "value") return static_cast<bool>(in >> value);
+    }
+    return false;
+}
+
+// Everything the stats report needs from one (length, sample) job
+struct SampleResult {
+    Word word;
+    double value = -1;
+    double seconds = 0;
+    bool duplicate = false; // an earlier sample has the same cache key
+    InfiniteCriterion criterion = InfiniteCriterion::NONE; // infinite without computing
+    bool minimal = true;
+    Word minimal_word;
+};
 
 int main(int argc, char* argv[]) {
+    const CommandLineOptions options = extractOptions(argc, argv);
+    if (!options.lp_export_dir.empty()) {
+        std::error_code error;
+        std::filesystem::create_directories(options.lp_export_dir, error);
+        if (error) {
+            std::cerr << "Cannot create '" << options.lp_export_dir << "': " << error.message() << std::endl;
+            return 1;
+        }
+    }
+
     if (argc < 2) {
         std::cerr << "Usage: " << argv[0] << " mode [additional arguments]" << std::endl;
         std::cerr << "Modes:" << std::endl;
-        std::cerr << "  single [problem_type] [r] [m (if required)] [word_as_integers]" << std::endl;
-        std::cerr << "  stats [problem_type] [r] [m (if required)] [min_length] [max_length] [num_samples_per_length]" << std::endl;
+        std::cerr << "  single [problem_type] [r] [m (if required)] [word_as_integers] [--threads N] [--column-generation] [--certificate FILE]"
+                  << " [--export-lp DIR [--export-format mps|lp]] [--lp-backend NAME] [--deadline SECONDS]" << std::endl;
+        std::cerr << "  stats [problem_type] [r] [m (if required)] [min_length] [max_length] [num_samples_per_length] [--threads N] [--seed S] [--cache-size C]"
+                  << " [--column-generation] [--export-lp DIR [--export-format mps|lp]] [--lp-backend NAME]" << std::endl;
+        std::cerr << "  enumerate [problem_type] [r] [m (if required)] [min_length] [max_length] [--threads N] [--column-generation] [--export-lp DIR [--export-format mps|lp]] [--lp-backend NAME]" << std::endl;
+        std::cerr << "  verify [certificate_file] [--check-dual]" << std::endl;
+        std::cerr << "  replay [model_directory] [--lp-backend NAME]" << std::endl;
         return 1;
     }
 
@@ -41,9 +158,52 @@ int main(int argc, char* argv[]) {
             word.push_back(std::stoi(argv[i]));
         }
 
-        double result = calculate_stable_invariant(word, problem_type, r, m);
+        if (options.deadline_seconds > 0) {
+            // Anytime mode: report the bound after every stage and stop at the deadline
+            auto report = [](const AnytimeBound& bound) {
+                std::cout << "Stage " << bound.edges << "/" << bound.max_edges << ": " << bound.subgraphs << " subgraphs, ";
+                if (bound.lower_bound >= 0) std::cout << "lower bound " << bound.lower_bound;
+                else std::cout << "no lower bound yet";
+                std::cout << " (" << bound.seconds << "s)" << std::endl;
+            };
+            const AnytimeBound bound = calculate_stable_invariant_anytime(word, problem_type, r, m, options.calculation(options.threads), report);
+            if (!options.certificate_file.empty()) std::cout << "No certificate: anytime mode does not produce one." << std::endl;
+            if (bound.complete && bound.lower_bound >= 0) {
+                std::cout << "The stable primitivity rank is: " << bound.lower_bound << std::endl;
+            } else if (bound.complete) {
+                std::cout << "Calculation failed or is not supported." << std::endl;
+            } else if (bound.lower_bound >= 0) {
+                std::cout << "Deadline reached after stage " << bound.edges << " of " << bound.max_edges
+                          << ": the stable primitivity rank is at least " << bound.lower_bound << std::endl;
+            } else {
+                std::cout << "Deadline reached after stage " << bound.edges << " of " << bound.max_edges << ": no bound yet" << std::endl;
+            }
+            return 0;
+        }
+
+        Exact::Optimum exact;
+        OptimalityCertificate certificate;
+        const bool want_certificate = !options.certificate_file.empty();
+        double result = calculate_stable_invariant(word, problem_type, r, m, options.calculation(options.threads), &exact, want_certificate ? &certificate : nullptr);
         if (result >= 0) {
             std::cout << "The stable primitivity rank is: " << result << std::endl;
+            if (exact.certified) {
+                std::cout << "Exact value: " << exact.objective.toString() << " (certified in " << exact.seconds << " seconds)" << std::endl;
+            } else {
+                std::cout << "Exact value: could not be certified" << std::endl;
+            }
+            if (want_certificate) {
+                if (certificate.graphs.empty()) {
+                    std::cout << "No certificate: only the full LP produces one." << std::endl;
+                } else {
+                    std::ofstream certificate_out(options.certificate_file);
+                    writeCertificate(certificate_out, certificate);
+                    std::cout << "Certificate written to '" << options.certificate_file << "' (" << certificate.graphs.size()
+                              << " graphs, " << certificate.gluing_duals.size() << " nonzero duals)." << std::endl;
+                }
+            }
+        } else if (const InfiniteCriterion criterion = detect_infinite_result(word, r); criterion != InfiniteCriterion::NONE) {
+            std::cout << "The stable primitivity rank is infinite: " << infinite_criterion_name(criterion) << "." << std::endl;
         } else {
             std::cout << "Calculation failed or is not supported." << std::endl;
         }
@@ -77,35 +237,86 @@ int main(int argc, char* argv[]) {
             return 1;
         }
 
+        // Every sample gets its own generator derived from the seed, so the output only
+        // depends on the seed and not on the number of threads
+        uint64_t seed = options.seed;
+        if (!options.has_seed) {
+            std::random_device rd;
+            seed = (static_cast<uint64_t>(rd()) << 32) | rd();
+        }
+
         // Write a header for clarity
         outfile << "Statistics Output\n";
-        outfile << "=================\n\n";
+        outfile << "=================\n";
+        outfile << "Seed: " << seed << "\n\n";
 
         // Pre-generate all Type II automorphisms once
         std::cout << "Generating Type II Whitehead automorphisms..." << std::endl;
         std::vector<Automorphism> automorphisms = generate_typeII(r);
         std::cout << "Generated " << automorphisms.size() << " Type II automorphisms.\n" << std::endl;
 
-        // For each length in the interval, generate words and compute statistics
-        for (int length = min_length; length <= max_length; ++length) {
+        // Random words often repeat up to rotation, inversion and relabeling, so values are
+        // cached by canonical word
+        StableInvariantCache cache(options.cache_size);
+        CalculationOptions sample_options = options.calculation(1);
+        sample_options.infinite_prechecked = true; // each sample runs detect_infinite_result itself
+
+        // Run every (length, sample) job on the worker pool
+        const int num_lengths = std::max(0, max_length - min_length + 1);
+        std::vector<SampleResult> samples(static_cast<size_t>(num_lengths) * std::max(0, num_samples));
+        Parallel::parallelFor(samples.size(), options.threads, [&](size_t job) {
+            const int length = min_length + static_cast<int>(job / num_samples);
+            const int sample = static_cast<int>(job % num_samples);
+            SampleResult& out = samples[job];
             auto start = std::chrono::high_resolution_clock::now();
+
+            // Generate a random reduced word of the given length
+            std::mt19937 gen = make_sample_generator(seed, length, sample);
+            out.word = generate_random_reduced_word(length, r, gen);
+            // Words whose value is infinite by a pre-check skip the cache and the minimality check
+            out.criterion = detect_infinite_result(out.word, r);
+            out.value = out.criterion != InfiniteCriterion::NONE ? -1 : calculate_stable_invariant_cached(out.word, problem_type, r, m, cache, nullptr, sample_options);
+            if (out.value < 0 && out.criterion == InfiniteCriterion::NONE) {
+                // Check if the word is minimal, and if not find a minimal word
+                out.minimal = is_minimal(out.word, r, automorphisms);
+                if (!out.minimal) {
+                    out.minimal_word = get_minimal_word(out.word, r);
+                }
+            }
+            out.seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        }, release_thread_solver_state);
+
+        // Duplicates are counted by cache key in sample order, so the report does not depend on
+        // which worker reached a word first or on what the cache evicted meanwhile
+        std::set<std::vector<int>> seen_keys;
+        int duplicates = 0;
+        for (SampleResult& result : samples) {
+            if (result.criterion != InfiniteCriterion::NONE) continue;
+            result.duplicate = !seen_keys.insert(stable_invariant_cache_key(result.word, problem_type, r, m)).second;
+            if (result.duplicate) duplicates++;
+        }
+
+        // Reduce the results per length, in sample order
+        for (int length = min_length; length <= max_length; ++length) {
             std::vector<double> results;
             int infty_counter = 0;
-            std::vector<Word> infty_words; // To store words resulting in infinity
+            std::vector<const SampleResult*> infty_samples; // To store words resulting in infinity
+            double elapsed = 0; // summed over samples, i.e. the serial running time
+            int length_duplicates = 0;
+            int prechecked = 0;
 
             for (int sample = 0; sample < num_samples; ++sample) {
-                // Generate a random reduced word of the given length
-                std::vector<int> word = generate_random_reduced_word(length, r);
-                double result = calculate_stable_invariant(word, problem_type, r, m);
-                if (result >= 0) {
-                    results.push_back(result);
+                const SampleResult& result = samples[static_cast<size_t>(length - min_length) * num_samples + sample];
+                elapsed += result.seconds;
+                if (result.duplicate) length_duplicates++;
+                if (result.criterion != InfiniteCriterion::NONE) prechecked++;
+                if (result.value >= 0) {
+                    results.push_back(result.value);
                 } else {
                     infty_counter++;
-                    infty_words.push_back(word);
+                    infty_samples.push_back(&result);
                 }
             }
-            auto end = std::chrono::high_resolution_clock::now();
-            std::chrono::duration<double> elapsed = end - start;
 
             // Write statistics for this length to the file
             outfile << "Length " << length << ":\n";
@@ -122,32 +333,27 @@ int main(int argc, char* argv[]) {
             }
 
             // Process and write 'infty' words
-            if (!infty_words.empty()) {
+            if (!infty_samples.empty()) {
                 outfile << "\nWords Resulting in Infinity:\n";
                 outfile << "----------------------------\n";
-                for(const auto& word : infty_words){
+                for(const SampleResult* result : infty_samples){
                     // Convert word to a string representation
                     std::string word_str = "";
-                    for(auto c : word){
+                    for(auto c : result->word){
                         word_str += std::to_string(c) + " ";
                     }
 
-                    // Check if the word is minimal
-                    bool minimal = is_minimal(word, r, automorphisms);
-
-                    // If not minimal, find a minimal word
-                    Word minimal_word;
-                    if(!minimal){
-                        minimal_word = get_minimal_word(word, r);
-                    }
-
                     // Write the information to the file
                     outfile << "Word: " << word_str << "\n";
-                    outfile << "Is Minimal: " << (minimal ? "Yes" : "No") << "\n";
-                    if(!minimal){
+                    if (result->criterion != InfiniteCriterion::NONE) {
+                        outfile << "Pre-check: " << infinite_criterion_name(result->criterion) << "\n\n";
+                        continue;
+                    }
+                    outfile << "Is Minimal: " << (result->minimal ? "Yes" : "No") << "\n";
+                    if(!result->minimal){
                         // Convert minimal_word to string
                         std::string minimal_word_str = "";
-                        for(auto c : minimal_word){
+                        for(auto c : result->minimal_word){
                             minimal_word_str += std::to_string(c) + " ";
                         }
                         outfile << "Minimal Word: " << minimal_word_str << "\n";
@@ -156,18 +362,222 @@ int main(int argc, char* argv[]) {
                 }
             }
 
-            outfile << "Elapsed time for length " << length << ": " << elapsed.count() << " seconds\n";
+            outfile << "Infinite by pre-check = " << prechecked << "\n";
+            outfile << "Duplicates by key = " << length_duplicates << ", Distinct keys = " << num_samples - length_duplicates - prechecked << "\n";
+            outfile << "Elapsed time for length " << length << ": " << elapsed << " seconds\n";
             outfile << "========================================\n\n";
 
             // Optional: Print progress to console
-            std::cout << "Processed length " << length << " in " << elapsed.count() << " seconds." << std::endl;
+            std::cout << "Processed length " << length << " in " << elapsed << " seconds." << std::endl;
         }
 
+        outfile << "Duplicates by key: " << duplicates << " (" << seen_keys.size() << " distinct keys)\n";
         outfile.close();
+        std::cout << "\nCache: " << cache.hits() << " hits, " << cache.misses() << " misses" << std::endl;
         std::cout << "\nStatistics have been written to 'stats_output.txt'." << std::endl;
 
+    } else if (mode == "enumerate") {
+        // Handle exhaustive enumeration, one word per orbit
+        if (argc < 6 || (PROBLEM_TYPE(std::stoi(argv[2])) == PROBLEM_TYPE::SPI_M && argc < 7)) {
+            std::cerr << "Usage: " << argv[0] << " enumerate [problem_type] [r] [m (if required)] [min_length] [max_length]" << std::endl;
+            return 1;
+        }
+
+        const PROBLEM_TYPE problem_type = PROBLEM_TYPE(std::stoi(argv[2]));
+        int arg_index = 3;
+
+        // Parse the rank of the free group
+        int r = std::stoi(argv[arg_index++]);
+
+        int m = -1;
+        if (problem_type == PROBLEM_TYPE::SPI_M) {
+            m = std::stoi(argv[arg_index++]);
+        }
+
+        int min_length = std::stoi(argv[arg_index++]);
+        int max_length = std::stoi(argv[arg_index++]);
+
+        // Open the output file
+        std::ofstream outfile("enumerate_output.txt");
+        if (!outfile.is_open()) {
+            std::cerr << "Error: Could not open 'enumerate_output.txt' for writing." << std::endl;
+            return 1;
+        }
+
+        outfile << "Enumeration Output\n";
+        outfile << "==================\n\n";
+
+        for (int length = min_length; length <= max_length; ++length) {
+            auto start = std::chrono::high_resolution_clock::now();
+
+            // One representative per orbit under rotation, inversion and signed permutation;
+            // every word in an orbit has the same value
+            const std::vector<Word> representatives = generate_canonical_cyclic_words(length, r);
+            std::vector<double> values(representatives.size());
+            Parallel::parallelFor(representatives.size(), options.threads, [&](size_t i) {
+                values[i] = calculate_stable_invariant(representatives[i], problem_type, r, m, options.calculation(1));
+            }, release_thread_solver_state);
+
+            // Exact distribution over all cyclically reduced words of this length
+            std::map<double, long long> words_per_value;
+            long long finite_words = 0;
+            long long infinite_words = 0;
+            double weighted_sum = 0;
+            outfile << "Length " << length << ":\n";
+            outfile << "--------------\n";
+            for (size_t i = 0; i < representatives.size(); ++i) {
+                const long long orbit_size = cyclic_orbit_size(representatives[i], r);
+                std::string word_str = "";
+                for (auto c : representatives[i]) {
+                    word_str += std::to_string(c) + " ";
+                }
+                outfile << "Word: " << word_str << "| Value: ";
+                if (values[i] >= 0) {
+                    outfile << values[i];
+                    words_per_value[std::round(values[i] * 1e6) / 1e6] += orbit_size; // merge LP round-off
+                    finite_words += orbit_size;
+                    weighted_sum += values[i] * orbit_size;
+                } else {
+                    outfile << "infinity";
+                    infinite_words += orbit_size;
+                }
+                outfile << " | Orbit size: " << orbit_size << "\n";
+            }
+
+            outfile << "\nDistribution (value: words):\n";
+            for (const auto& [value, count] : words_per_value) {
+                outfile << "  " << value << ": " << count << "\n";
+            }
+            if (infinite_words > 0) outfile << "  infinity: " << infinite_words << "\n";
+            if (finite_words > 0) {
+                outfile << "Mean = " << weighted_sum / finite_words << ", ";
+            }
+            outfile << "Finite = " << finite_words << ", Infinite = " << infinite_words
+                    << ", Orbits = " << representatives.size() << "\n";
+
+            const double elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+            outfile << "Elapsed time for length " << length << ": " << elapsed << " seconds\n";
+            outfile << "========================================\n\n";
+
+            std::cout << "Processed length " << length << " (" << representatives.size() << " orbits) in " << elapsed << " seconds." << std::endl;
+        }
+
+        outfile.close();
+        std::cout << "\nEnumeration has been written to 'enumerate_output.txt'." << std::endl;
+
+    } else if (mode == "verify") {
+        // Re-check a certificate written by single mode
+        if (argc < 3) {
+            std::cerr << "Usage: " << argv[0] << " verify [certificate_file] [--check-dual]" << std::endl;
+            return 1;
+        }
+
+        std::ifstream infile(argv[2]);
+        if (!infile.is_open()) {
+            std::cerr << "Error opening file '" << argv[2] << "'." << std::endl;
+            return 1;
+        }
+        OptimalityCertificate certificate;
+        std::string error;
+        if (!readCertificate(infile, certificate, error)) {
+            std::cerr << "Malformed certificate: " << error << std::endl;
+            return 1;
+        }
+
+        const auto start = std::chrono::high_resolution_clock::now();
+        const CertificateCheck check = verifyCertificate(certificate, options.check_dual);
+        const double elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        if (!check.valid || (check.dual_checked && !check.dual_feasible)) {
+            std::cout << "Certificate rejected: " << check.error << std::endl;
+            return 1;
+        }
+        std::cout << "Certificate accepted: value " << certificate.value.toString() << " (" << certificate.graphs.size()
+                  << " graphs, checked in " << elapsed << " seconds)" << std::endl;
+        if (check.dual_checked) {
+            std::cout << "Dual feasible: " << check.subgraphs_priced << " subgraphs priced, " << check.subgraphs_unfolded
+                      << " unfolded; the value is the optimum." << std::endl;
+        } else {
+            std::cout << "Dual feasibility not checked (use --check-dual to prove optimality)." << std::endl;
+        }
+
+    } else if (mode == "replay") {
+        // Time the solve stage alone on the models written by --export-lp, on every LP backend
+        // or on the one given with --lp-backend
+        if (argc < 3) {
+            std::cerr << "Usage: " << argv[0] << " replay [model_directory] [--lp-backend NAME]" << std::endl;
+            return 1;
+        }
+
+        std::vector<std::filesystem::path> models;
+        std::error_code error;
+        for (const auto& entry : std::filesystem::directory_iterator(argv[2], error)) {
+            const std::string extension = entry.path().extension().string();
+            if (entry.is_regular_file() && (extension == ".mps" || extension == ".lp")) models.push_back(entry.path());
+        }
+        if (error) {
+            std::cerr << "Cannot read '" << argv[2] << "': " << error.message() << std::endl;
+            return 1;
+        }
+        std::sort(models.begin(), models.end());
+
+        std::ofstream outfile("replay_output.txt");
+        if (!outfile.is_open()) {
+            std::cerr << "Error opening file for writing." << std::endl;
+            return 1;
+        }
+
+        std::vector<LpBackendKind> backends = allLpBackends();
+        if (options.has_lp_backend) backends.assign(1, options.lp_backend);
+        std::vector<double> total_seconds(backends.size(), 0.0);
+        std::vector<int> solved(backends.size(), 0), mismatches(backends.size(), 0), delegated(backends.size(), 0);
+        outfile << "Replay of " << models.size() << " models in " << argv[2] << "\n";
+        outfile << "===============================\n";
+        for (const auto& model_path : models) {
+            outfile << model_path.filename().string();
+            LinearProgramModel model;
+            const ModelFormat format = model_path.extension() == ".lp" ? ModelFormat::CPLEX_LP : ModelFormat::MPS;
+            if (!readLinearProgramModel(model_path.string(), format, model)) {
+                outfile << " | unreadable\n";
+                continue;
+            }
+            double expected = -1;
+            std::filesystem::path sidecar = model_path;
+            const bool has_sidecar = readSidecarValue(sidecar.replace_extension(".columns").string(), expected);
+
+            outfile << " | " << model.numRows() << " rows x " << model.numColumns() << " columns";
+            for (size_t b = 0; b < backends.size(); ++b) {
+                const ModelReplay replay = replayLinearProgramModel(model, backends[b]);
+                total_seconds[b] += replay.seconds;
+                solved[b] += replay.optimal;
+                const bool agrees = !has_sidecar || (replay.optimal == (expected >= 0) &&
+                                                     (!replay.optimal || std::fabs(replay.objective - expected) <= 1e-6));
+                mismatches[b] += !agrees;
+                delegated[b] += replay.delegated;
+                outfile << " | " << lpBackendName(backends[b]) << ": " << replay.seconds << "s";
+                if (replay.optimal) outfile << ", " << replay.objective;
+                else outfile << ", not optimal";
+                if (replay.delegated) outfile << " (delegated)";
+                if (!agrees) outfile << " (expected " << expected << ")";
+            }
+            outfile << "\n";
+        }
+
+        outfile << "\nTotals:\n";
+        for (size_t b = 0; b < backends.size(); ++b) {
+            outfile << "  " << lpBackendName(backends[b]) << ": " << total_seconds[b] << " seconds, " << solved[b] << " of "
+                    << models.size() << " optimal, " << mismatches[b] << " disagree with the exported value";
+            if (delegated[b] > 0) outfile << ", " << delegated[b] << " delegated";
+            outfile << "\n";
+            std::cout << std::left << std::setw(16) << lpBackendName(backends[b]) << std::right << " " << total_seconds[b]
+                      << " seconds, " << solved[b] << "/" << models.size() << " optimal, " << mismatches[b] << " mismatches";
+            if (delegated[b] > 0) std::cout << ", " << delegated[b] << " delegated";
+            std::cout << std::endl;
+        }
+        outfile.close();
+        std::cout << "\nReplay has been written to 'replay_output.txt'." << std::endl;
+
     } else {
-        std::cerr << "Invalid mode. Use 'single' or 'stats'." << std::endl;
+        std::cerr << "Invalid mode. Use 'single', 'stats', 'enumerate', 'verify' or 'replay'." << std::endl;
         return 1;
     }
 
@@ -1,11 +1,24 @@
 #include "linear_program_construction.h"
 
+double EquationConstruction::getObjectiveCoefficient(const WhiteheadGraph& graph){
+    return graph.getVertices().size() / 2 - graph.getConnectedComponents().size();
+}
+
+// Blocks have at least two half-edges, and every valid component has at least two vertices,
+// so V/2 - #components <= floor(sum floor(deg/2) / 2) - 1
+double EquationConstruction::getObjectiveUpperBound(const WhiteheadGraph& subgraph){
+    size_t max_vertices = 0;
+    for (int vertex : subgraph.getVertices()) {
+        max_vertices += (subgraph.getInDegree(vertex) + subgraph.getOutDegree(vertex)) / 2;
+    }
+    return static_cast<double>(max_vertices / 2) - 1.0;
+}
+
 const std::vector<double> EquationConstruction::getObjective(const std::vector<WhiteheadGraph> & graphs){
     std::vector<double> minus_chi_per_graph;
     minus_chi_per_graph.reserve(graphs.size());
     for (int i=0; i<graphs.size(); i++){
-        const auto& graph = graphs[i];
-        minus_chi_per_graph.push_back(graph.getVertices().size() / 2 - graph.getConnectedComponents().size());
+        minus_chi_per_graph.push_back(getObjectiveCoefficient(graphs[i]));
     }
     return minus_chi_per_graph;
 }
\ No newline at end of file
@@ -0,0 +1,172 @@
+#include <vector>
+#include <array>
+#include <unordered_set>
+#include <algorithm>
+#include <cmath>
+#include "linear_program_construction.h"
+
+// Presolve for the stable invariant LP (max c x s.t. gluing rows = 0, degree row = 1, x >= 0).
+//
+// A gluing row whose coefficients all have the same sign forces its graphs to zero, since
+// x >= 0. Removing those graphs can leave further rows one-signed, so forced zeros are
+// propagated until nothing changes. Rows left with no graphs, and rows that repeat another row
+// up to sign, are then dropped, and so are the forced-zero columns and columns that no longer
+// appear in any row and cannot improve the objective.
+namespace {
+    typedef std::vector<std::pair<int, double>> SparseRow;
+
+    struct SparseRowHash {
+        std::size_t operator()(const SparseRow& row) const {
+            std::size_t seed = row.size();
+            for (const auto& [j, coefficient] : row) {
+                seed ^= std::hash<int>{}(j) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+                seed ^= std::hash<double>{}(coefficient) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            }
+            return seed;
+        }
+    };
+}
+
+PresolvedLinearProgram presolveLinearProgram(const std::vector<double>& objective_coeffs, const std::vector<std::pair<std::vector<int>, std::vector<int>>>& constraint_pairs, const std::vector<int>& degree_equation) {
+    PresolvedLinearProgram result;
+    const int numVars = objective_coeffs.size();
+
+    // Step 1: Net coefficients; rows that cancel completely are already gone
+    const SparseRows rows = assembleGluingRows(constraint_pairs, numVars);
+    const int numRows = rows.size();
+    result.original_rows = numRows + 1;
+    result.original_columns = numVars;
+
+    // Step 2: Propagate forced zeros to a fixpoint. live[r] counts the graphs with positive
+    // (side 0) and negative (side 1) coefficient in row r that are not forced to zero yet; a row
+    // goes on the queue when a side runs empty.
+    std::vector<std::vector<std::pair<int, int>>> rows_of_column(numVars); // (row, side)
+    std::vector<std::array<int, 2>> live(numRows, {0, 0});
+    std::vector<int> queue;
+    for (int r = 0; r < numRows; ++r) {
+        for (int k = rows.start[r]; k < rows.start[r + 1]; ++k) {
+            const int side = rows.value[k] > 0 ? 0 : 1;
+            rows_of_column[rows.column[k]].emplace_back(r, side);
+            live[r][side]++;
+        }
+        if (live[r][0] == 0 || live[r][1] == 0) queue.push_back(r);
+    }
+    std::vector<char> forced_zero(numVars, 0);
+    while (!queue.empty()) {
+        const int r = queue.back();
+        queue.pop_back();
+        int forced_sign = 0;
+        for (int k = rows.start[r]; k < rows.start[r + 1]; ++k) {
+            const int j = rows.column[k];
+            if (forced_zero[j]) continue;
+            forced_zero[j] = 1;
+            forced_sign = rows.value[k] > 0 ? 1 : -1;
+            result.forced_zero_columns++;
+            for (const auto& [other, other_side] : rows_of_column[j]) {
+                if (--live[other][other_side] == 0 && live[other][1 - other_side] > 0) queue.push_back(other);
+            }
+        }
+        if (forced_sign != 0) result.forcing_rows.emplace_back(r, forced_sign);
+    }
+    auto is_live = [&](int r) { return live[r][0] > 0 && live[r][1] > 0; };
+
+    // Step 3: Keep the columns that are not forced to zero and still matter: they are in a live
+    // row or the degree row, or they are unconstrained with a positive objective coefficient,
+    // which leaves the LP unbounded as before
+    std::vector<char> in_live_row(numVars, 0);
+    for (int r = 0; r < numRows; ++r) {
+        if (!is_live(r)) continue;
+        for (int k = rows.start[r]; k < rows.start[r + 1]; ++k) in_live_row[rows.column[k]] = 1;
+    }
+    for (int j : degree_equation) in_live_row[j] = 1;
+    std::vector<int> new_index(numVars, -1);
+    for (int j = 0; j < numVars; ++j) {
+        if (forced_zero[j] || (!in_live_row[j] && objective_coeffs[j] <= 0)) continue;
+        new_index[j] = result.original_column.size();
+        result.original_column.push_back(j);
+        result.objective.push_back(objective_coeffs[j]);
+    }
+    for (int j : degree_equation) {
+        if (new_index[j] >= 0) result.degree_equation.push_back(new_index[j]);
+    }
+    result.infeasible = result.degree_equation.empty();
+
+    // Step 4: Renumber the live rows, sorted by column and scaled so that the first coefficient
+    // is positive, and keep one copy of each
+    std::unordered_set<SparseRow, SparseRowHash> seen;
+    SparseRow row;
+    for (int r = 0; r < numRows; ++r) {
+        if (!is_live(r)) continue;
+        row.clear();
+        for (int k = rows.start[r]; k < rows.start[r + 1]; ++k) {
+            if (new_index[rows.column[k]] >= 0) row.emplace_back(new_index[rows.column[k]], rows.value[k]);
+        }
+        std::sort(row.begin(), row.end());
+        const int sign = row.front().second < 0 ? -1 : 1;
+        if (sign < 0) {
+            for (auto& entry : row) entry.second = -entry.second;
+        }
+        if (!seen.insert(row).second) {
+            result.duplicate_rows++;
+            continue;
+        }
+        for (const auto& [j, coefficient] : row) {
+            result.gluing_rows.column.push_back(j);
+            result.gluing_rows.value.push_back(coefficient);
+        }
+        result.gluing_rows.start.push_back(result.gluing_rows.column.size());
+        result.gluing_rows.origin.push_back(rows.origin[r]);
+        result.row_sign.push_back(sign);
+    }
+    return result;
+}
+
+std::vector<double> PresolvedLinearProgram::expandSolution(const std::vector<double>& solution) const {
+    if (solution.empty()) return solution;
+    std::vector<double> expanded(original_columns, 0.0);
+    for (size_t j = 0; j < solution.size(); ++j) {
+        expanded[original_column[j]] = solution[j];
+    }
+    return expanded;
+}
+
+std::vector<double> PresolvedLinearProgram::expandDuals(const std::vector<double>& duals, const std::vector<double>& objective_coeffs, const std::vector<std::pair<std::vector<int>, std::vector<int>>>& constraint_pairs, const std::vector<int>& degree_equation) const {
+    std::vector<double> expanded(constraint_pairs.size() + 1, 0.0);
+    if (duals.empty()) return expanded;
+    expanded[0] = duals[0];
+    for (int i = 0; i < gluing_rows.size(); ++i) {
+        expanded[gluing_rows.origin[i] + 1] = row_sign[i] * duals[i + 1];
+    }
+    if (forcing_rows.empty()) return expanded;
+
+    // Reduced costs of every original column under the duals so far
+    const SparseRows rows = assembleGluingRows(constraint_pairs, objective_coeffs.size());
+    std::vector<double> reduced_cost = objective_coeffs;
+    for (int j : degree_equation) reduced_cost[j] -= expanded[0];
+    for (int r = 0; r < rows.size(); ++r) {
+        const double y = expanded[rows.origin[r] + 1];
+        if (y == 0) continue;
+        for (int k = rows.start[r]; k < rows.start[r + 1]; ++k) {
+            reduced_cost[rows.column[k]] -= y * rows.value[k];
+        }
+    }
+
+    // A forcing row only holds forced columns: those on its forcing side, and those on the
+    // other side that earlier rows had already forced. Its dual lowers the reduced costs of
+    // the former and raises those of the latter, so rows are handled last to first, and every
+    // column is covered by the row that forced it after all later rows are done. The dual is
+    // rounded up to an integer with room to spare, which survives rationalization.
+    for (auto it = forcing_rows.rbegin(); it != forcing_rows.rend(); ++it) {
+        const auto [r, sign] = *it;
+        double needed = 0;
+        for (int k = rows.start[r]; k < rows.start[r + 1]; ++k) {
+            if (rows.value[k] * sign > 0) needed = std::max(needed, reduced_cost[rows.column[k]] / std::fabs(rows.value[k]));
+        }
+        const double y = sign * (std::floor(needed) + 1);
+        expanded[rows.origin[r] + 1] += y;
+        for (int k = rows.start[r]; k < rows.start[r + 1]; ++k) {
+            reduced_cost[rows.column[k]] -= y * rows.value[k];
+        }
+    }
+    return expanded;
+}
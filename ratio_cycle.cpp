@@ -0,0 +1,249 @@
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include "lp_backend.h"
+
+// Experimental combinatorial backend: the stable invariant LP as a maximum ratio cycle problem.
+//
+// Apart from the normalization row, every row reads "inflow = outflow" at one gluing key pair.
+// A column with at most one +1 and at most one -1 among those rows is an arc: from the row of
+// its +1 to the row of its -1, with a root node standing in for a missing end. Over such
+// columns, the solutions of the gluing rows are the circulations, so the LP asks for the cycle
+// C with the largest ratio c(C) / d(C), d being the normalization row. Dinkelbach's iteration
+// finds it: for the current ratio lambda, look for a cycle with positive weight c - lambda d;
+// if there is one, its ratio is larger and becomes the next lambda, otherwise lambda is the
+// optimum and the longest-path potentials of the final search are optimal duals. Cycles are
+// found with Bellman-Ford, which stops at the first cycle in its predecessor graph.
+//
+// The columns that are not arcs are left out of the search and priced against those duals at
+// the end. If one of them has a positive reduced cost, or the network alone is infeasible or
+// unbounded, the LP is handed to GLPK instead.
+namespace {
+    const double kTolerance = 1e-9;
+    const int kMaxRatioIterations = 1000;
+
+    struct Arc {
+        int tail;   // node of the +1 row, 0 for the root
+        int head;   // node of the -1 row, 0 for the root
+        int column;
+    };
+
+    class RatioCycleBackend : public LpBackend {
+    public:
+        bool load(const LinearProgramModel& model_, const ModelDelta& delta, int& rewritten_columns) override;
+        Solution solve() override;
+        void certify(const LinearProgramModel& model_, Solution& solution, Exact::Optimum& exact) override;
+        void reset() override;
+
+    private:
+        const LinearProgramModel* model = nullptr;
+        std::unique_ptr<LpBackend> fallback;
+        bool delegated = false;
+
+        // The network, rebuilt at every load
+        int normalization_row = -1;    // 0-based
+        double normalization_rhs = 0;
+        std::vector<int> node_of_row;  // 0-based row -> node, -1 for the normalization row
+        int nodes = 0;
+        std::vector<Arc> arcs;
+        std::vector<int> root_loops;   // columns in no gluing row
+        std::vector<double> degree;    // normalization coefficient per column
+
+        // Bellman-Ford state of the last search
+        std::vector<double> distance;
+        std::vector<int> predecessor;  // arc that last improved each node
+
+        bool buildNetwork();
+        bool findPositiveCycle(double lambda, std::vector<int>& cycle);
+        bool solveNetwork(Solution& solution);
+        Solution delegate();
+    };
+
+    void RatioCycleBackend::reset() {
+        model = nullptr;
+        if (fallback) fallback->reset();
+    }
+
+    bool RatioCycleBackend::load(const LinearProgramModel& model_, const ModelDelta&, int& rewritten_columns) {
+        model = &model_;
+        rewritten_columns = model_.numColumns();
+        return false;
+    }
+
+    // Sorts the arcs and root loops out of the columns; false if the rows do not have the
+    // shape of the stable invariant LP (one positive right-hand side, zeros elsewhere)
+    bool RatioCycleBackend::buildNetwork() {
+        const int numRows = model->numRows();
+        normalization_row = -1;
+        for (int i = 0; i < numRows; ++i) {
+            if (model->rhs[i] == 0) continue;
+            if (normalization_row >= 0 || model->rhs[i] < 0) return false;
+            normalization_row = i;
+        }
+        if (normalization_row < 0) return false;
+        normalization_rhs = model->rhs[normalization_row];
+
+        node_of_row.assign(numRows, -1);
+        nodes = 1;
+        for (int i = 0; i < numRows; ++i) {
+            if (i != normalization_row) node_of_row[i] = nodes++;
+        }
+
+        arcs.clear();
+        root_loops.clear();
+        degree.assign(model->numColumns(), 0.0);
+        for (int j = 0; j < model->numColumns(); ++j) {
+            int tail = 0, head = 0;
+            bool is_arc = true;
+            for (const auto& [row, coefficient] : model->columns[j]) {
+                if (row - 1 == normalization_row) {
+                    degree[j] += coefficient;
+                } else if (coefficient == 1.0 && tail == 0) {
+                    tail = node_of_row[row - 1];
+                } else if (coefficient == -1.0 && head == 0) {
+                    head = node_of_row[row - 1];
+                } else {
+                    is_arc = false;
+                }
+            }
+            if (degree[j] < 0) return false;
+            if (!is_arc) continue;
+            if (tail == 0 && head == 0) root_loops.push_back(j);
+            else arcs.push_back({tail, head, j});
+        }
+        return true;
+    }
+
+    // Bellman-Ford for longest paths under the weights c - lambda d, from every node at once.
+    // An arc u -> v asks for pi_u >= pi_v + w, so it improves u from v. Returns a cycle of
+    // positive weight as its columns, or false once the distances settle.
+    bool RatioCycleBackend::findPositiveCycle(double lambda, std::vector<int>& cycle) {
+        cycle.clear();
+        for (int j : root_loops) {
+            if (model->objective[j] - lambda * degree[j] > kTolerance) {
+                cycle.push_back(j);
+                return true;
+            }
+        }
+
+        distance.assign(nodes, 0.0);
+        predecessor.assign(nodes, -1);
+        std::vector<int> state(nodes);
+        for (int round = 0; round < nodes; ++round) {
+            bool improved = false;
+            for (size_t a = 0; a < arcs.size(); ++a) {
+                const Arc& arc = arcs[a];
+                const double candidate = distance[arc.head] + model->objective[arc.column] - lambda * degree[arc.column];
+                if (candidate > distance[arc.tail] + kTolerance) {
+                    distance[arc.tail] = candidate;
+                    predecessor[arc.tail] = a;
+                    improved = true;
+                }
+            }
+            if (!improved) return false;
+
+            // A cycle among the predecessor arcs has positive weight; look for one after every
+            // round rather than only after the last
+            std::fill(state.begin(), state.end(), 0); // 0 unseen, 1 on the current walk, 2 done
+            for (int start = 0; start < nodes && cycle.empty(); ++start) {
+                int u = start;
+                while (u >= 0 && state[u] == 0) {
+                    state[u] = 1;
+                    u = predecessor[u] >= 0 ? arcs[predecessor[u]].head : -1;
+                }
+                if (u >= 0 && state[u] == 1) {
+                    int v = u;
+                    do {
+                        cycle.push_back(arcs[predecessor[v]].column);
+                        v = arcs[predecessor[v]].head;
+                    } while (v != u);
+                }
+                for (u = start; u >= 0 && state[u] == 1; u = predecessor[u] >= 0 ? arcs[predecessor[u]].head : -1) {
+                    state[u] = 2;
+                }
+            }
+            if (!cycle.empty()) return true;
+        }
+        return false;
+    }
+
+    bool RatioCycleBackend::solveNetwork(Solution& solution) {
+        if (!buildNetwork()) return false;
+
+        // Step 1: Dinkelbach's iteration from below every cycle ratio; each cycle a search
+        // returns has a larger ratio than the last, so the number of rounds is finite
+        double objective_norm = 1.0;
+        for (double c : model->objective) objective_norm += std::fabs(c);
+        double lambda = -objective_norm;
+        std::vector<int> cycle, best_cycle;
+        bool settled = false;
+        for (int iteration = 0; iteration < kMaxRatioIterations; ++iteration) {
+            if (!findPositiveCycle(lambda, cycle)) {
+                settled = true;
+                break;
+            }
+            double cost = 0, weight = 0;
+            for (int j : cycle) {
+                cost += model->objective[j];
+                weight += degree[j];
+            }
+            if (weight <= kTolerance) return false; // unbounded, if feasible at all
+            const double ratio = cost / weight;
+            if (ratio <= lambda + kTolerance) return false; // lost to rounding
+            lambda = ratio;
+            best_cycle.swap(cycle);
+        }
+        if (!settled || best_cycle.empty()) return false;
+
+        // Step 2: Duals from the potentials, relative to the root. The columns left out of the
+        // search must not price out; the arcs are checked too, against rounding in the search.
+        std::vector<double> y(model->numRows(), 0.0);
+        y[normalization_row] = lambda;
+        for (int i = 0; i < model->numRows(); ++i) {
+            if (node_of_row[i] >= 0) y[i] = distance[node_of_row[i]] - distance[0];
+        }
+        for (int j = 0; j < model->numColumns(); ++j) {
+            double reduced_cost = model->objective[j];
+            for (const auto& [row, coefficient] : model->columns[j]) reduced_cost -= coefficient * y[row - 1];
+            if (reduced_cost > kTolerance) return false;
+        }
+
+        // Step 3: The best cycle, scaled to meet the normalization row
+        double weight = 0;
+        for (int j : best_cycle) weight += degree[j];
+        solution.x.assign(model->numColumns(), 0.0);
+        for (int j : best_cycle) solution.x[j] += normalization_rhs / weight;
+        solution.objective = 0;
+        for (int j : best_cycle) solution.objective += model->objective[j] * solution.x[j];
+        solution.row_duals.swap(y);
+        solution.optimal = true;
+        return true;
+    }
+
+    LpBackend::Solution RatioCycleBackend::delegate() {
+        if (!fallback) fallback = makeLpBackend(LpBackendKind::GLPK_PRIMAL);
+        ModelDelta delta;
+        delta.changed.assign(model->numColumns(), 1);
+        int rewritten_columns = 0;
+        fallback->load(*model, delta, rewritten_columns);
+        Solution solution = fallback->solve();
+        solution.delegated = true;
+        return solution;
+    }
+
+    LpBackend::Solution RatioCycleBackend::solve() {
+        Solution solution;
+        delegated = !solveNetwork(solution);
+        if (delegated) return delegate();
+        return solution;
+    }
+
+    void RatioCycleBackend::certify(const LinearProgramModel& model_, Solution& solution, Exact::Optimum& exact) {
+        if (delegated) fallback->certify(model_, solution, exact);
+        else LpBackend::certify(model_, solution, exact);
+    }
+}
+
+std::unique_ptr<LpBackend> makeRatioCycleBackend() {
+    return std::make_unique<RatioCycleBackend>();
+}
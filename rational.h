@@ -0,0 +1,109 @@
+#ifndef rational_h
+#define rational_h
+
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <numeric>
+#include <string>
+
+namespace Exact {
+    // Fraction of two int64 values, always in lowest terms with a positive denominator.
+    // Arithmetic is carried out in __int128; a result that does not fit back into int64
+    // sets the overflow flag instead of wrapping, and the flag is sticky through later
+    // operations, so a whole computation can be checked once at the end.
+    class Rational {
+    public:
+        Rational() = default;
+        Rational(int64_t numerator_) : num(numerator_) {}
+        Rational(__int128 numerator_, __int128 denominator_, bool overflow_ = false) { assign(numerator_, denominator_, overflow_); }
+
+        int64_t numerator() const { return num; }
+        int64_t denominator() const { return den; }
+        bool overflowed() const { return overflow; }
+        double toDouble() const { return static_cast<double>(num) / static_cast<double>(den); }
+        std::string toString() const { return std::to_string(num) + "/" + std::to_string(den); }
+
+        Rational operator+(const Rational& other) const {
+            return Rational(static_cast<__int128>(num) * other.den + static_cast<__int128>(other.num) * den,
+                            static_cast<__int128>(den) * other.den, overflow || other.overflow);
+        }
+        Rational operator-(const Rational& other) const {
+            return Rational(static_cast<__int128>(num) * other.den - static_cast<__int128>(other.num) * den,
+                            static_cast<__int128>(den) * other.den, overflow || other.overflow);
+        }
+        Rational operator*(const Rational& other) const {
+            return Rational(static_cast<__int128>(num) * other.num, static_cast<__int128>(den) * other.den,
+                            overflow || other.overflow);
+        }
+        Rational& operator+=(const Rational& other) { return *this = *this + other; }
+        bool operator==(const Rational& other) const { return num == other.num && den == other.den; }
+        bool operator!=(const Rational& other) const { return !(*this == other); }
+        int sign() const { return (num > 0) - (num < 0); }
+
+    private:
+        int64_t num = 0;
+        int64_t den = 1;
+        bool overflow = false;
+
+        static __int128 gcd128(__int128 a, __int128 b) {
+            if (a < 0) a = -a;
+            if (b < 0) b = -b;
+            while (b != 0) {
+                const __int128 t = a % b;
+                a = b;
+                b = t;
+            }
+            return a;
+        }
+
+        void assign(__int128 n, __int128 d, bool overflow_) {
+            overflow = overflow_;
+            if (d < 0) { n = -n; d = -d; }
+            const __int128 g = gcd128(n, d);
+            if (g > 1) { n /= g; d /= g; }
+            if (n > INT64_MAX || n < -INT64_MAX || d > INT64_MAX) {
+                overflow = true;
+                num = 0;
+                den = 1;
+                return;
+            }
+            num = static_cast<int64_t>(n);
+            den = static_cast<int64_t>(d);
+        }
+    };
+
+    // Best rational approximation of value with denominator at most max_denominator, by
+    // continued fractions. Never overflows, unlike scaling by 10 until the value is integral.
+    inline Rational rationalize(double value, int64_t max_denominator) {
+        const bool negative = value < 0;
+        double x = std::fabs(value);
+        if (x > 1e12) return Rational(0, 1, true);
+        // Convergents h/k of the continued fraction of x
+        int64_t h_prev = 1, h = static_cast<int64_t>(std::floor(x));
+        int64_t k_prev = 0, k = 1;
+        double remainder = x - std::floor(x);
+        while (remainder > 1e-12) {
+            x = 1.0 / remainder;
+            const int64_t a = static_cast<int64_t>(std::floor(x));
+            remainder = x - std::floor(x);
+            if (a > (max_denominator - k_prev) / k) break;
+            const int64_t h_next = a * h + h_prev;
+            const int64_t k_next = a * k + k_prev;
+            h_prev = h; h = h_next;
+            k_prev = k; k = k_next;
+            if (std::fabs(static_cast<double>(h) / k - std::fabs(value)) < 1e-12 * std::max(1.0, std::fabs(value))) break;
+        }
+        return Rational(negative ? -static_cast<__int128>(h) : h, k);
+    }
+
+    // Exact LP optimum; certified only if the rationalized primal and dual solutions were
+    // checked to be feasible and to have equal objective values in exact arithmetic
+    struct Optimum {
+        bool certified = false;
+        Rational objective;
+        double seconds = 0; // time spent on the exact pass
+    };
+}
+
+#endif
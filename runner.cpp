@@ -2,9 +2,21 @@
 #include "stable_invariants_types.h"
 #include "linear_program_construction.h"
 #include <numeric>
+#include <memory>
+#include <cmath>
 #include <iostream>
 #include "runner.h"
+#include "thread_pool.h"
+#include "whitehead_automorphisms.h"
+#include "certificate.h"
 #include <random>
+#include <unordered_map>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <thread>
+#include <filesystem>
+#include <chrono>
 
 
 // Helper function to display the WhiteheadGraph objects based on their indices
@@ -33,17 +45,10 @@ int lcm(int a, int b) {
     return (a * b) / gcd(a, b);
 }
 
-// Function to convert a double to a fraction
+// Function to convert a double to a fraction (continued fractions, so it cannot overflow)
 std::pair<int, int> doubleToFraction(double num) {
-    const double epsilon = 1e-9;  // Tolerance for floating-point comparisons
-    int denominator = 1;
-    
-    while (std::fabs(num - std::round(num)) > epsilon) {
-        num *= 10;
-        denominator *= 10;
-    }
-
-    return {static_cast<int>(num), denominator};
+    const Exact::Rational fraction = Exact::rationalize(num, 1000000);
+    return {static_cast<int>(fraction.numerator()), static_cast<int>(fraction.denominator())};
 }
 
 // Function to find the LCM of denominators in a vector of doubles
@@ -79,104 +84,492 @@ std::vector<int> getNonZeroIndices(const std::vector<double>& vec) {
     std::vector<int> indices;
     const double epsilon = 1e-9;  // Tolerance for floating-point comparisons
     for (size_t i = 0; i < vec.size(); ++i) {
-        if (abs(vec[i]) > epsilon) {
+        if (std::fabs(vec[i]) > epsilon) {
             indices.push_back(i);  // Store the index of non-zero value
         }
     }
     return indices;
 }
 
-void build_linear_program(std::vector<WhiteheadGraph>& filteredGraphs, std::vector<WhiteheadGraph>& partitioned_graphs, std::vector<std::pair<std::vector<int>, std::vector<int>>>& constraint_pairs, const std::vector<int>& word, PROBLEM_TYPE problem_type, int m=0) {
-    std::unique_ptr<StableInvariant> invariant;
+std::unique_ptr<StableInvariant> make_invariant(PROBLEM_TYPE problem_type, int m) {
     switch (problem_type){
         case PROBLEM_TYPE::SPI:
-            return; // currently not supported
+            return nullptr; // currently not supported
         case PROBLEM_TYPE::SPI_M:
-            invariant = std::make_unique<Spi_m>(m); break;
+            return std::make_unique<Spi_m>(m);
         case PROBLEM_TYPE::SPI_NO_ORIGAMI:
-            invariant = std::make_unique<SpiNoOrigami>(); break;
+            return std::make_unique<SpiNoOrigami>();
         default:
-            return; // currently not supported
+            return nullptr; // currently not supported
     };
+}
+
+// Where a kept graph came from: the valid subgraph it unfolds and its index in that
+// subgraph's unfolding enumeration. Enough to rebuild the graph on demand.
+struct GraphOrigin {
+    int subgraph;
+    uint64_t unfolding;
+};
+
+// Replay state per subgraph, for rebuilding many kept graphs at once
+typedef std::unordered_map<int, VariableConstruction::UnfoldingReplayer> ReplayerCache;
+
+WhiteheadGraph replay_graph(const std::vector<WhiteheadGraph>& validSubgraphs, const GraphOrigin& origin, PROBLEM_TYPE problem_type, ReplayerCache* replayers = nullptr) {
+    if (problem_type == PROBLEM_TYPE::SPI_M) return validSubgraphs[origin.subgraph];
+    if (!replayers) return VariableConstruction::replayUnfolding(validSubgraphs[origin.subgraph], origin.unfolding);
+    auto it = replayers->try_emplace(origin.subgraph, validSubgraphs[origin.subgraph]).first;
+    return it->second.replay(origin.unfolding);
+}
+
+void build_linear_program(EquationConstruction::LinearProgramData& lp_data, std::vector<GraphOrigin>& origins, const std::vector<WhiteheadGraph>& validSubgraphs, std::vector<std::pair<std::vector<int>, std::vector<int>>>& constraint_pairs, const std::vector<int>& word, PROBLEM_TYPE problem_type, int m=0, int threads=1, VariableConstruction::UnfoldingStats* unfolding_stats=nullptr, std::vector<EquationConstruction::GluingKey>* row_keys=nullptr) {
+    std::unique_ptr<StableInvariant> invariant = make_invariant(problem_type, m);
     if (!invariant) return;
-    // Step 4: Filter the list of partitioned subgraphs
-    filteredGraphs = VariableConstruction::filterValidWhiteheadGraphsFromPartitions(partitioned_graphs, *invariant);
-    // displayWhiteheadGraphs(filteredGraphs);
-    // std::cout<<"after filtered, got "<<filteredGraphs.size()<<" subgraphs:\n";
-    // displayWhiteheadGraphs(filteredGraphs);
+
+    // Step 3+4: Unfold every valid subgraph by partitioning and replacing vertices, filter the
+    // result, and reduce each kept graph straight into its objective coefficient, first-letter
+    // flag and gluing keys; the graph itself is dropped. Subgraphs are independent, so they are
+    // fanned out over the worker pool and merged back in subgraph order to keep LP variable
+    // indices stable.
+    std::vector<EquationConstruction::LinearProgramData> dataPerSubgraph(validSubgraphs.size());
+    std::vector<std::vector<uint64_t>> keptPerSubgraph(validSubgraphs.size());
+    std::vector<VariableConstruction::UnfoldingStats> statsPerSubgraph(validSubgraphs.size());
+    Parallel::parallelFor(validSubgraphs.size(), threads, [&](size_t i) {
+        auto keep_if_valid = [&](uint64_t index, const WhiteheadGraph& graph) {
+            if (!VariableConstruction::isValidUnfolding(graph, *invariant)) return;
+            dataPerSubgraph[i].addGraph(graph);
+            keptPerSubgraph[i].push_back(index);
+        };
+        if (problem_type == PROBLEM_TYPE::SPI_M) {
+            keep_if_valid(0, validSubgraphs[i]);
+        } else {
+            VariableConstruction::forEachUnfolding(validSubgraphs[i], keep_if_valid, &statsPerSubgraph[i]);
+        }
+    });
+    lp_data = EquationConstruction::LinearProgramData();
+    origins.clear();
+    for (size_t i = 0; i < validSubgraphs.size(); ++i) {
+        lp_data.append(std::move(dataPerSubgraph[i]));
+        for (const uint64_t index : keptPerSubgraph[i]) {
+            origins.push_back({static_cast<int>(i), index});
+        }
+    }
+    if (unfolding_stats) {
+        for (const auto& stats : statsPerSubgraph) {
+            const uint64_t room = UINT64_MAX - unfolding_stats->possible_combinations;
+            unfolding_stats->possible_combinations += std::min(room, stats.possible_combinations);
+            unfolding_stats->generated_combinations += stats.generated_combinations;
+        }
+    }
 
     // Step 5: Get the gluing constraints
-    constraint_pairs = EquationConstruction::getGluingEquations(filteredGraphs, word.size(), *invariant);
+    constraint_pairs = EquationConstruction::getGluingEquations(lp_data, word.size(), row_keys);
 
     return;
 
 }
 
-double calculate_stable_invariant(const std::vector<int>& word, PROBLEM_TYPE problem_type, int r, int m, bool display) {
-    // Step 1: Create the CoreWhiteheadGraph from the word
-    CoreWhiteheadGraph coreWHGraph = constructCoreWhiteheadGraph(word, r);
+// Holds for every invariant: the degree equation sums over graphs that contain the position-1
+// edge. Primitivity is not a criterion, since SPI_M with m = 1 has finite values on primitive words.
+InfiniteCriterion detect_infinite_result(const std::vector<int>& word, int r) {
+    if (word.empty()) return InfiniteCriterion::NONE;
+    if (!VariableConstruction::isInMinimumDegreeCore(constructCoreWhiteheadGraph(word, r), 1)) {
+        return InfiniteCriterion::FIRST_EDGE_OUTSIDE_CORE;
+    }
+    return InfiniteCriterion::NONE;
+}
 
-    // Step 2: Generate valid subgraphs for any problem
-    std::unique_ptr<StableInvariant> invariant;
-    switch (problem_type){
-        case PROBLEM_TYPE::SPI:
-            return -1; // currently not supported
-        case PROBLEM_TYPE::SPI_M:
-            invariant = std::make_unique<Spi_m>(m); break;
-        case PROBLEM_TYPE::SPI_NO_ORIGAMI:
-            invariant = std::make_unique<SpiNoOrigami>(); break;
-        default:
-            return -1; // currently not supported
+const char* infinite_criterion_name(InfiniteCriterion criterion) {
+    switch (criterion) {
+        case InfiniteCriterion::NONE: return "none";
+        case InfiniteCriterion::FIRST_EDGE_OUTSIDE_CORE: return "no subgraph of minimum degree 2 contains the first edge";
+    }
+    return "unknown";
+}
+
+double calculate_stable_invariant(const std::vector<int>& word, PROBLEM_TYPE problem_type, int r, int m, bool display, int threads) {
+    CalculationOptions options;
+    options.display = display;
+    options.threads = threads;
+    return calculate_stable_invariant(word, problem_type, r, m, options);
+}
+
+// Column-generation variant of steps 3-8: only the best unfolding of each priced subgraph is
+// ever kept, and the displayed graphs are replayed from their enumeration index
+double solve_by_column_generation(const std::vector<WhiteheadGraph>& validSubgraphs, const std::vector<int>& word, PROBLEM_TYPE problem_type, StableInvariant& invariant, const CalculationOptions& options, Exact::Optimum* exact) {
+    const bool unfold = problem_type != PROBLEM_TYPE::SPI_M;
+    const ColumnGenerationResult result = solveByColumnGeneration(validSubgraphs, word.size(), invariant, unfold, options.threads, exact);
+    if (options.display) {
+        std::cout << "Column generation: " << result.rounds << " rounds, " << result.columns.size() << " columns, "
+                  << result.rows << " rows, unfolded " << result.subgraphs_unfolded << " of " << validSubgraphs.size() << " subgraphs\n";
+        for (const GeneratedColumn& column : result.columns) {
+            if (column.value <= 1e-9) continue;
+            std::cout << "Graph from subgraph " << column.subgraph << ", unfolding " << column.unfolding << ":\n";
+            const WhiteheadGraph graph = replay_graph(validSubgraphs, {column.subgraph, column.unfolding}, problem_type);
+            graph.printAdjacencyMatrix();
+            graph.displayGraph();
+        }
+    }
+    return result.objective;
+}
+
+// Blocks of signed half-edge positions, one per vertex of the graph
+std::vector<std::vector<int>> graph_blocks(const WhiteheadGraph& graph) {
+    std::unordered_map<int, int> block_of_vertex;
+    std::vector<std::vector<int>> blocks;
+    auto block = [&](int vertex) -> std::vector<int>& {
+        auto it = block_of_vertex.emplace(vertex, static_cast<int>(blocks.size())).first;
+        if (it->second == static_cast<int>(blocks.size())) blocks.emplace_back();
+        return blocks[it->second];
     };
-    if (!invariant) return -1;
+    for (const auto& [position, edge] : graph.getEdgesByPosition()) {
+        block(edge.first).push_back(position);
+        block(edge.second).push_back(-position);
+    }
+    return blocks;
+}
 
-    std::vector<WhiteheadGraph> validSubgraphs = VariableConstruction::findValidSubgraphsFromCore(coreWHGraph, *invariant);
+// Support graphs with their weights and the duals of the original LP, all as fractions
+void fill_certificate(OptimalityCertificate& certificate, const std::vector<int>& word, PROBLEM_TYPE problem_type, int r, int m,
+                      double value, const Exact::Optimum& exact, const std::vector<double>& solution,
+                      const std::vector<double>& duals, const std::vector<EquationConstruction::GluingKey>& row_keys,
+                      const std::vector<WhiteheadGraph>& validSubgraphs, const std::vector<GraphOrigin>& origins) {
+    const int64_t max_denominator = 1000000;
+    certificate = OptimalityCertificate();
+    certificate.problem_type = problem_type;
+    certificate.r = r;
+    certificate.m = m;
+    certificate.word = word;
+    certificate.value = exact.certified ? exact.objective : Exact::rationalize(value, max_denominator);
+    ReplayerCache replayers;
+    for (int idx : getNonZeroIndices(solution)) {
+        const WhiteheadGraph graph = replay_graph(validSubgraphs, origins[idx], problem_type, &replayers);
+        certificate.graphs.push_back({Exact::rationalize(solution[idx], max_denominator), graph_blocks(graph)});
+    }
+    certificate.degree_dual = Exact::rationalize(duals[0], max_denominator);
+    for (size_t i = 0; i < row_keys.size(); ++i) {
+        const Exact::Rational dual = Exact::rationalize(duals[i + 1], max_denominator);
+        if (dual.sign() != 0) certificate.gluing_duals.push_back({row_keys[i].positions(), dual});
+    }
+}
 
-    // Step 3: Create a new list of subgraphs by partitioning and replacing vertices
-    std::vector<WhiteheadGraph> partitionedGraphs;
-    if (problem_type == PROBLEM_TYPE::SPI_M) { 
-        partitionedGraphs = validSubgraphs; 
+// Name of a word's LP in the export directory, without extension; long words are hashed to
+// keep within file name limits
+std::string model_name(const std::vector<int>& word, PROBLEM_TYPE problem_type, int r, int m) {
+    std::ostringstream name;
+    name << "lp_t" << static_cast<int>(problem_type) << "_r" << r;
+    if (problem_type == PROBLEM_TYPE::SPI_M) name << "_m" << m;
+    std::ostringstream letters;
+    for (size_t i = 0; i < word.size(); ++i) letters << (i ? "_" : "") << word[i];
+    if (word.size() <= 48) {
+        name << "_w" << letters.str();
     } else {
-        for (const auto& subgraph : validSubgraphs) {
-            std::vector<WhiteheadGraph> partitioned = VariableConstruction::partitionAndReplaceVertices(subgraph);
-            partitionedGraphs.insert(partitionedGraphs.end(), partitioned.begin(), partitioned.end());
+        name << "_h" << std::hex << std::hash<std::string>{}(letters.str());
+    }
+    return name.str();
+}
+
+// Writes the LP just solved on this thread and a sidecar that maps its columns back to graphs:
+//   stable-invariant-lp 1
+//   problem <type> <r> <m>
+//   word <n> <letters...>
+//   value <objective found in process, -1 if none>
+//   columns <count>
+//   <column> <graph index> <objective> <blocks> { <size> <signed positions...> }   (one line per LP column)
+//   end
+// Both files go through a temporary name, so workers exporting the same word never leave a
+// torn file behind.
+bool export_linear_program(const CalculationOptions& options, const std::vector<int>& word, PROBLEM_TYPE problem_type, int r, int m,
+                           double value, const PresolvedLinearProgram& presolved, const EquationConstruction::LinearProgramData& lp_data,
+                           const std::vector<WhiteheadGraph>& validSubgraphs, const std::vector<GraphOrigin>& origins) {
+    const std::filesystem::path base = std::filesystem::path(options.lp_export_dir) / model_name(word, problem_type, r, m);
+    const std::string suffix = ".tmp" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    const std::string model_path = base.string() + (options.lp_export_cplex ? ".lp" : ".mps");
+    const std::string sidecar_path = base.string() + ".columns";
+
+    std::error_code error;
+    auto discard = [&]() {
+        std::filesystem::remove(model_path + suffix, error);
+        std::filesystem::remove(sidecar_path + suffix, error);
+        return false;
+    };
+    const ModelFormat format = options.lp_export_cplex ? ModelFormat::CPLEX_LP : ModelFormat::MPS;
+    if (!LinearProgramSolverContext::forThisThread().writeModel(model_path + suffix, format)) return discard();
+    {
+        std::ofstream out(sidecar_path + suffix);
+        out << "stable-invariant-lp 1\n";
+        out << "problem " << static_cast<int>(problem_type) << " " << r << " " << m << "\n";
+        out << "word " << word.size();
+        for (int letter : word) out << " " << letter;
+        out << "\nvalue " << std::setprecision(17) << value << "\n";
+        out << "columns " << presolved.columns() << "\n";
+        ReplayerCache replayers;
+        for (int j = 0; j < presolved.columns(); ++j) {
+            const int idx = presolved.original_column[j];
+            const std::vector<std::vector<int>> blocks = graph_blocks(replay_graph(validSubgraphs, origins[idx], problem_type, &replayers));
+            out << j + 1 << " " << idx << " " << lp_data.objective[idx] << " " << blocks.size();
+            for (const auto& block : blocks) {
+                out << " " << block.size();
+                for (int half_edge : block) out << " " << half_edge;
+            }
+            out << "\n";
         }
+        out << "end\n";
+        if (!out) return discard();
     }
+    std::filesystem::rename(model_path + suffix, model_path, error);
+    if (!error) std::filesystem::rename(sidecar_path + suffix, sidecar_path, error);
+    return !error;
+}
 
-    // Step 4: Build linear program
-    std::vector<std::pair<std::vector<int>, std::vector<int>>> constraint_pairs;
-    std::vector<WhiteheadGraph> filteredGraphs;
+double calculate_stable_invariant(const std::vector<int>& word, PROBLEM_TYPE problem_type, int r, int m, const CalculationOptions& options, Exact::Optimum* exact, OptimalityCertificate* certificate) {
+    const bool display = options.display;
+    const int threads = options.threads;
+
+    // Step 1: Create the CoreWhiteheadGraph from the word, unless the result is known to be
+    // infinite without it
+    const InfiniteCriterion criterion = options.infinite_prechecked ? InfiniteCriterion::NONE : detect_infinite_result(word, r);
+    if (criterion != InfiniteCriterion::NONE) {
+        if (display) std::cout << "Infinite before enumeration: " << infinite_criterion_name(criterion) << "\n";
+        return -1;
+    }
+    CoreWhiteheadGraph coreWHGraph = constructCoreWhiteheadGraph(word, r);
 
-    build_linear_program(filteredGraphs, partitionedGraphs, constraint_pairs, word, problem_type, m);
+    // Step 2: Generate valid subgraphs for any problem
+    std::unique_ptr<StableInvariant> invariant = make_invariant(problem_type, m);
+    if (!invariant) return -1;
 
-    // Step 5: Get the objective function from the graphs
-    const auto& obj_coeffs = EquationConstruction::getObjective(filteredGraphs);
+    VariableConstruction::SubgraphSearchStats search_stats;
+    std::vector<WhiteheadGraph> validSubgraphs = VariableConstruction::findValidSubgraphsFromCore(coreWHGraph, *invariant, &search_stats);
+    if (display) {
+        std::cout << "Subgraph search explored " << search_stats.explored << " nodes, emitted "
+                  << search_stats.emitted << " candidates, kept " << validSubgraphs.size() << " subgraphs\n";
+    }
+    if (options.column_generation) {
+        return solve_by_column_generation(validSubgraphs, word, problem_type, *invariant, options, exact);
+    }
 
-    // Step 6: Find graphs that contain an edge from the first letter of the original word
-    std::vector<int> indicesWithFirstLetterEdge = EquationConstruction::findGraphsWithFirstLetterEdge(filteredGraphs);
+    // Step 3-6: Build linear program (unfolding, filtering, objective, first-letter graphs and
+    // gluing constraints) without keeping the unfolded graphs
+    std::vector<std::pair<std::vector<int>, std::vector<int>>> constraint_pairs;
+    EquationConstruction::LinearProgramData lp_data;
+    std::vector<GraphOrigin> origins;
+
+    VariableConstruction::UnfoldingStats unfolding_stats;
+    std::vector<EquationConstruction::GluingKey> row_keys;
+    build_linear_program(lp_data, origins, validSubgraphs, constraint_pairs, word, problem_type, m, threads, &unfolding_stats, certificate ? &row_keys : nullptr);
+    if (display && problem_type != PROBLEM_TYPE::SPI_M) {
+        std::cout << "Unfolding generated " << unfolding_stats.generated_combinations << " of "
+                  << unfolding_stats.possible_combinations << " partition combinations, kept "
+                  << lp_data.numGraphs() << " graphs\n";
+    }
 
-    // Step 7: Solve the linear program
-    if (filteredGraphs.empty()) {
+    // Step 7: Presolve and solve the linear program
+    if (lp_data.numGraphs() == 0) {
         // std::cout << "No filtered graphs, terminating" << std::endl;
         return -1;
     }
-    const auto& obj_and_sol = getLinearProgramSolutionAndMinimizer(obj_coeffs, constraint_pairs, indicesWithFirstLetterEdge);
+    const PresolvedLinearProgram presolved = presolveLinearProgram(lp_data.objective, constraint_pairs, lp_data.first_letter_indices);
+    if (display) {
+        std::cout << "Presolve: " << presolved.original_rows << " rows x " << presolved.original_columns
+                  << " columns -> " << presolved.rows() << " rows x " << presolved.columns() << " columns ("
+                  << presolved.forced_zero_columns << " columns forced to zero, " << presolved.duplicate_rows
+                  << " duplicate rows)\n";
+    }
+    if (presolved.infeasible) return -1;
+    Exact::Optimum certificate_exact; // a certificate wants the exact pass, which also cleans up the duals
+    if (certificate && !exact) exact = &certificate_exact;
+    LinearProgramSolverContext::forThisThread().setBackend(options.lp_backend);
+    auto obj_and_sol = getLinearProgramSolutionAndMinimizer(presolved.objective, presolved.gluing_rows, presolved.degree_equation, exact);
+    obj_and_sol.second = presolved.expandSolution(obj_and_sol.second);
+    if (!options.lp_export_dir.empty() &&
+        !export_linear_program(options, word, problem_type, r, m, obj_and_sol.first, presolved, lp_data, validSubgraphs, origins)) {
+        std::cerr << "Could not export the LP to '" << options.lp_export_dir << "'" << std::endl;
+    }
+
+    if (display) {
+        const auto& timing = LinearProgramSolverContext::forThisThread().lastTiming();
+        std::cout << "LP (" << lpBackendName(timing.backend) << "): " << timing.rows << " rows x " << timing.columns << " columns, "
+                  << timing.rewritten_columns << " columns loaded, setup " << timing.setup_seconds
+                  << "s, solve " << timing.solve_seconds << "s (" << (timing.warm_start ? "warm" : "cold")
+                  << " start" << (timing.delegated ? ", delegated to glpk-primal" : "") << ")\n";
+    }
 
     // Step 8: Extract the result from the solution
     double stable_primitivity_rank = obj_and_sol.first;
+    const std::vector<double>& row_duals = LinearProgramSolverContext::forThisThread().lastRowDuals();
+    if (certificate && !row_duals.empty()) {
+        const std::vector<double> duals = presolved.expandDuals(row_duals, lp_data.objective, constraint_pairs, lp_data.first_letter_indices);
+        fill_certificate(*certificate, word, problem_type, r, m, stable_primitivity_rank, *exact, obj_and_sol.second,
+                         duals, row_keys, validSubgraphs, origins);
+    }
 
-    // Optionally, display the graphs corresponding to non-zero variables
-    if (display) displayWhiteheadGraphs(filteredGraphs, getNonZeroIndices(obj_and_sol.second));
+    // Optionally, display the graphs corresponding to non-zero variables, rebuilt from their origin
+    if (display) {
+        for (int idx : getNonZeroIndices(obj_and_sol.second)) {
+            std::cout << "Graph at index " << idx << ":\n";
+            const WhiteheadGraph graph = replay_graph(validSubgraphs, origins[idx], problem_type);
+            graph.printAdjacencyMatrix();
+            graph.displayGraph();
+        }
+    }
 
     return stable_primitivity_rank;
 }
 
+// The full LP over a family of valid subgraphs, as in steps 3-7 of calculate_stable_invariant
+double solve_subgraph_family(const std::vector<WhiteheadGraph>& validSubgraphs, const std::vector<int>& word, PROBLEM_TYPE problem_type, int m, const CalculationOptions& options) {
+    std::vector<std::pair<std::vector<int>, std::vector<int>>> constraint_pairs;
+    EquationConstruction::LinearProgramData lp_data;
+    std::vector<GraphOrigin> origins;
+    build_linear_program(lp_data, origins, validSubgraphs, constraint_pairs, word, problem_type, m, options.threads);
+    if (lp_data.numGraphs() == 0) return -1;
+    const PresolvedLinearProgram presolved = presolveLinearProgram(lp_data.objective, constraint_pairs, lp_data.first_letter_indices);
+    if (presolved.infeasible) return -1;
+    LinearProgramSolverContext::forThisThread().setBackend(options.lp_backend);
+    return getLinearProgramSolutionAndMinimizer(presolved.objective, presolved.gluing_rows, presolved.degree_equation).first;
+}
+
+AnytimeBound calculate_stable_invariant_anytime(const std::vector<int>& word, PROBLEM_TYPE problem_type, int r, int m, const CalculationOptions& options, const std::function<void(const AnytimeBound&)>& on_stage) {
+    const auto start = std::chrono::steady_clock::now();
+    VariableConstruction::SubgraphSearchBounds bounds;
+    if (options.deadline_seconds > 0) {
+        bounds.deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(options.deadline_seconds));
+    }
+
+    AnytimeBound bound;
+    std::unique_ptr<StableInvariant> invariant = make_invariant(problem_type, m);
+    if (word.empty() || !invariant) return bound;
+    bound.max_edges = word.size();
+    if (detect_infinite_result(word, r) != InfiniteCriterion::NONE) {
+        bound.complete = true;
+        bound.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return bound;
+    }
+    const CoreWhiteheadGraph coreWHGraph = constructCoreWhiteheadGraph(word, r);
+
+    std::vector<WhiteheadGraph> family;
+    for (int edges = 2; edges <= bound.max_edges; ++edges) {
+        // Step 1: Add the valid subgraphs with exactly this many core edges
+        bounds.min_edges = bounds.max_edges = edges;
+        VariableConstruction::SubgraphSearchStats search_stats;
+        std::vector<WhiteheadGraph> stage = VariableConstruction::findValidSubgraphsFromCore(coreWHGraph, *invariant, &search_stats, &bounds);
+        if (search_stats.stopped) break;
+        family.insert(family.end(), std::make_move_iterator(stage.begin()), std::make_move_iterator(stage.end()));
+
+        // Step 2: Re-solve if the family grew; more columns can only raise the optimum
+        if (!stage.empty()) {
+            bound.lower_bound = std::max(bound.lower_bound, solve_subgraph_family(family, word, problem_type, m, options));
+        }
+        bound.edges = edges;
+        bound.subgraphs = family.size();
+        bound.complete = edges == bound.max_edges;
+        bound.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (on_stage) on_stage(bound);
+        if (std::chrono::steady_clock::now() >= bounds.deadline) break;
+    }
+    return bound;
+}
+
+size_t StableInvariantCache::KeyHash::operator()(const std::vector<int>& key) const {
+    size_t seed = key.size();
+    for (int letter : key) {
+        seed ^= std::hash<int>{}(letter) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    }
+    return seed;
+}
+
+bool StableInvariantCache::lookup(const std::vector<int>& key, double& value) {
+    if (capacity == 0) {
+        std::lock_guard<std::mutex> lock(mutex);
+        miss_count++;
+        return false;
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    inserted.wait(lock, [&]() { return claimed.count(key) == 0; });
+    auto it = index.find(key);
+    if (it == index.end()) {
+        claimed.insert(key);
+        miss_count++;
+        return false;
+    }
+    entries.splice(entries.begin(), entries, it->second);
+    value = it->second->second;
+    hit_count++;
+    return true;
+}
+
+void StableInvariantCache::insert(const std::vector<int>& key, double value) {
+    if (capacity == 0) return;
+    std::lock_guard<std::mutex> lock(mutex);
+    claimed.erase(key);
+    inserted.notify_all();
+    auto it = index.find(key);
+    if (it != index.end()) {
+        entries.splice(entries.begin(), entries, it->second);
+        return;
+    }
+    entries.emplace_front(key, value);
+    index[key] = entries.begin();
+    if (entries.size() > capacity) {
+        index.erase(entries.back().first);
+        entries.pop_back();
+    }
+}
+
+uint64_t StableInvariantCache::hits() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return hit_count;
+}
+
+uint64_t StableInvariantCache::misses() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return miss_count;
+}
+
+std::vector<int> stable_invariant_cache_key(const std::vector<int>& word, PROBLEM_TYPE problem_type, int r, int m) {
+    // Rotating or relabeling is only sound for cyclically reduced words; anything else is
+    // keyed as given
+    std::vector<int> key = {static_cast<int>(problem_type), r, m};
+    const std::vector<int> canonical = is_cyclically_reduced(word) ? canonical_cyclic_word(word) : word;
+    key.insert(key.end(), canonical.begin(), canonical.end());
+    return key;
+}
+
+double calculate_stable_invariant_cached(const std::vector<int>& word, PROBLEM_TYPE problem_type, int r, int m, StableInvariantCache& cache, bool* hit, const CalculationOptions& options) {
+    const std::vector<int> key = stable_invariant_cache_key(word, problem_type, r, m);
+
+    double value;
+    const bool found = cache.lookup(key, value);
+    if (hit) *hit = found;
+    if (found) return value;
+
+    value = calculate_stable_invariant(word, problem_type, r, m, options);
+    cache.insert(key, value);
+    return value;
+}
+
 std::vector<int> generate_random_reduced_word(int length, int r) {
+    std::random_device rd;
+    std::mt19937 gen(rd());
+    return generate_random_reduced_word(length, r, gen);
+}
+
+// Independent generator per (length, sample), so a sample's word does not depend on
+// which thread draws it or in which order
+std::mt19937 make_sample_generator(uint64_t seed, int length, int sample) {
+    std::seed_seq seq{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32),
+                      static_cast<uint32_t>(length), static_cast<uint32_t>(sample)};
+    return std::mt19937(seq);
+}
+
+void release_thread_solver_state() {
+    releaseLinearProgramSolverThreadState();
+}
+
+std::vector<int> generate_random_reduced_word(int length, int r, std::mt19937& gen) {
     std::vector<int> word;
     word.reserve(length);
 
-    std::random_device rd;
-    std::mt19937 gen(rd());
     std::uniform_int_distribution<> dis(1, 2 * r);
 
     int prev_letter = 0; // No previous letter initially
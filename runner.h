@@ -2,6 +2,18 @@
 #define runner_h
 
 #include <vector>
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+#include <condition_variable>
+#include <random>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <functional>
+#include "rational.h"
+#include "lp_backend.h"
 
 enum class PROBLEM_TYPE{
     SPI = 0,
@@ -9,7 +21,91 @@ enum class PROBLEM_TYPE{
     SPI_NO_ORIGAMI = 2
 };
 
-double calculate_stable_invariant(const std::vector<int>& word, PROBLEM_TYPE problem_type, int r, int m = -1, bool display=false);
+class StableInvariant;
+struct OptimalityCertificate;
+
+// Cheap sufficient conditions for an infinite result (-1), checked before any enumeration
+enum class InfiniteCriterion {
+    NONE = 0,
+    FIRST_EDGE_OUTSIDE_CORE = 1 // no subgraph of minimum degree 2 contains the position-1 edge
+};
+
+// How calculate_stable_invariant runs, as opposed to what it computes
+struct CalculationOptions {
+    bool display = false;
+    int threads = 1;
+    bool column_generation = false; // price unfoldings lazily instead of building the full LP
+    std::string lp_export_dir;      // if set, each full LP is written there with a column sidecar
+    bool lp_export_cplex = false;   // CPLEX LP format instead of MPS
+    LpBackendKind lp_backend = LpBackendKind::GLPK_PRIMAL; // for the full LP; column generation always uses GLPK
+    double deadline_seconds = 0;    // for calculate_stable_invariant_anytime; 0 runs to completion
+    bool infinite_prechecked = false; // the caller already ran detect_infinite_result on the word
+};
+
+// How far calculate_stable_invariant_anytime got. Stage k holds the valid subgraphs with at
+// most k core edges; any such family's LP optimum is a lower bound on the invariant, since its
+// columns are columns of the full LP.
+struct AnytimeBound {
+    int edges = 0;           // last stage solved, 0 if none
+    int max_edges = 0;       // the word length, at which the family is complete
+    size_t subgraphs = 0;
+    double lower_bound = -1; // -1 while every stage was infeasible
+    bool complete = false;   // lower_bound is the invariant (-1 meaning infinite)
+    double seconds = 0;
+};
+
+// If exact is given, the LP optimum is also certified in exact rational arithmetic. If
+// certificate is given, it receives an optimality certificate for the value (full LP only).
+double calculate_stable_invariant(const std::vector<int>& word, PROBLEM_TYPE problem_type, int r, int m, const CalculationOptions& options, Exact::Optimum* exact = nullptr, OptimalityCertificate* certificate = nullptr);
+double calculate_stable_invariant(const std::vector<int>& word, PROBLEM_TYPE problem_type, int r, int m = -1, bool display=false, int threads=1);
+// Grows the subgraph family one core edge count at a time and re-solves the full LP after each
+// stage, calling on_stage with the current bound, until the family is complete or
+// options.deadline_seconds have passed. The deadline is checked inside the subgraph search and
+// between stages, so the LP of a stage may overrun it. Column generation is not used.
+AnytimeBound calculate_stable_invariant_anytime(const std::vector<int>& word, PROBLEM_TYPE problem_type, int r, int m, const CalculationOptions& options, const std::function<void(const AnytimeBound&)>& on_stage = nullptr);
+InfiniteCriterion detect_infinite_result(const std::vector<int>& word, int r);
+const char* infinite_criterion_name(InfiniteCriterion criterion);
 std::vector<int> generate_random_reduced_word(int length, int r);
+std::vector<int> generate_random_reduced_word(int length, int r, std::mt19937& gen);
+std::mt19937 make_sample_generator(uint64_t seed, int length, int sample);
+void release_thread_solver_state();
+std::unique_ptr<StableInvariant> make_invariant(PROBLEM_TYPE problem_type, int m); // nullptr if unsupported
+
+// Bounded LRU cache of invariant values keyed by problem parameters and canonical word.
+// Safe to share between worker threads; a capacity of 0 disables it. A miss claims the key
+// until insert is called for it, and other lookups of a claimed key wait for that insert, so
+// no two workers compute the same key at once.
+class StableInvariantCache {
+public:
+    explicit StableInvariantCache(size_t capacity_) : capacity(capacity_) {}
+
+    bool lookup(const std::vector<int>& key, double& value); // false: the caller must insert key
+    void insert(const std::vector<int>& key, double value);
+    uint64_t hits() const;
+    uint64_t misses() const;
+
+private:
+    struct KeyHash {
+        size_t operator()(const std::vector<int>& key) const;
+    };
+    typedef std::list<std::pair<std::vector<int>, double>> EntryList; // most recently used first
+
+    size_t capacity;
+    EntryList entries;
+    std::unordered_map<std::vector<int>, EntryList::iterator, KeyHash> index;
+    std::unordered_set<std::vector<int>, KeyHash> claimed; // missed, not inserted yet
+    uint64_t hit_count = 0;
+    uint64_t miss_count = 0;
+    mutable std::mutex mutex;
+    std::condition_variable inserted;
+};
+
+// The cache key of a word: problem parameters followed by the canonical cyclic word. Words
+// that are equal up to rotation, inversion and signed permutation of the generators share it.
+std::vector<int> stable_invariant_cache_key(const std::vector<int>& word, PROBLEM_TYPE problem_type, int r, int m);
+
+// calculate_stable_invariant behind the cache. *hit reports whether the value came from the
+// cache; with several workers that depends on which of them reached a key first.
+double calculate_stable_invariant_cached(const std::vector<int>& word, PROBLEM_TYPE problem_type, int r, int m, StableInvariantCache& cache, bool* hit = nullptr, const CalculationOptions& options = CalculationOptions());
 
 #endif
\ No newline at end of file
@@ -0,0 +1,408 @@
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include "lp_backend.h"
+
+// Built-in LP backend: a bounded primal revised simplex specialized for the stable invariant LP.
+//
+// The LPs have equality rows, x >= 0, very sparse columns of small integers, and a right-hand
+// side that is zero except on the degree row. Phase 1 starts from the all-artificial basis,
+// where the artificials of zero rows are fixed at zero from the outset, so only the artificial
+// of the degree row has to be driven out; the fixed ones leave through degenerate pivots as
+// the phase goes on. The basis inverse is kept in product form (an eta file) and rebuilt every
+// kRefactorInterval pivots. The LPs are heavily degenerate, so the ratio test follows Harris
+// with a small tolerance and pricing turns to Bland's rule during long degenerate runs. If a
+// phase hits its iteration limit or a refactorization finds the basis singular, the LP is
+// handed to GLPK instead.
+namespace {
+    const double kFeasibilityTolerance = 1e-9;
+    const double kOptimalityTolerance = 1e-9;
+    const double kPivotTolerance = 1e-9;
+    const double kPhaseOneTolerance = 1e-7;
+    const int kRefactorInterval = 64;
+    const int kDegenerateRunLimit = 50;
+    const double kInfinity = std::numeric_limits<double>::infinity();
+
+    class SparseSimplexBackend : public LpBackend {
+    public:
+        bool load(const LinearProgramModel& model_, const ModelDelta& delta, int& rewritten_columns) override;
+        Solution solve() override;
+        void certify(const LinearProgramModel& model_, Solution& solution, Exact::Optimum& exact) override;
+        void reset() override;
+
+    private:
+        enum class Outcome { OPTIMAL, UNBOUNDED, FAILED };
+
+        const LinearProgramModel* model = nullptr;
+        std::unique_ptr<LpBackend> fallback;
+        bool delegated = false;
+        int m = 0;                     // rows
+        int n = 0;                     // structural columns; the artificial of row i is n + i
+        std::vector<double> row_sign;  // rows with b < 0 are negated, so every artificial starts at |b|
+        std::vector<double> b;         // right-hand side after the sign flips
+        std::vector<double> upper;     // per variable; every lower bound is 0
+        std::vector<double> cost;      // of the current phase
+        std::vector<int> head;         // basic variable of each basis position
+        std::vector<int> position;     // basis position of each variable, -1 if nonbasic
+        std::vector<double> value;     // of the basic variable at each position
+        std::vector<int> warm_basis;   // last optimal basis: j for column j, -(i + 1) for the artificial of row i
+        int pivots_since_refactor = 0;
+
+        // Eta file: B^-1 = E_k ... E_1, where E_k pivots on row eta_row[k] with the entries
+        // eta_start[k] .. eta_start[k + 1] of the other rows
+        std::vector<int> eta_row;
+        std::vector<double> eta_pivot;
+        std::vector<int> eta_start = {0};
+        std::vector<int> eta_index;
+        std::vector<double> eta_value;
+
+        std::vector<double> alpha;     // dense scratch for the entering column
+        std::vector<double> duals;
+        std::vector<double> signed_duals;
+
+        void scatterColumn(int var, std::vector<double>& dense) const;
+        void ftran(std::vector<double>& a) const;
+        void btran(std::vector<double>& y) const;
+        void clearEtas();
+        void pushEta(int row, const std::vector<double>& column);
+        bool refactor();
+        void computeValues();
+        void computeDuals();
+        double reducedCost(int j) const;
+        void setPhaseCosts(bool phase_one);
+        void startCold();
+        bool startWarm();
+        Outcome iterate();
+        Solution delegate();
+    };
+
+    void SparseSimplexBackend::reset() {
+        model = nullptr;
+        warm_basis.clear();
+        if (fallback) fallback->reset();
+    }
+
+    // The basis of the last optimum is kept if the rows are the same and none of its columns changed
+    bool SparseSimplexBackend::load(const LinearProgramModel& model_, const ModelDelta& delta, int& rewritten_columns) {
+        model = &model_;
+        m = model_.numRows();
+        n = model_.numColumns();
+        bool warm = !warm_basis.empty() && delta.previous_rows == m;
+        for (size_t k = 0; warm && k < warm_basis.size(); ++k) {
+            const int j = warm_basis[k];
+            if (j >= 0 && (j >= n || delta.changed[j])) warm = false;
+        }
+        if (!warm) warm_basis.clear();
+        rewritten_columns = warm ? n - delta.unchanged : n;
+
+        row_sign.assign(m, 1.0);
+        b.resize(m);
+        for (int i = 0; i < m; ++i) {
+            if (model_.rhs[i] < 0) row_sign[i] = -1.0;
+            b[i] = row_sign[i] * model_.rhs[i];
+        }
+        alpha.resize(m);
+        duals.resize(m);
+        signed_duals.resize(m);
+        return warm;
+    }
+
+    void SparseSimplexBackend::scatterColumn(int var, std::vector<double>& dense) const {
+        std::fill(dense.begin(), dense.end(), 0.0);
+        if (var >= n) {
+            dense[var - n] = 1.0;
+            return;
+        }
+        for (const auto& [row, coefficient] : model->columns[var]) {
+            dense[row - 1] += row_sign[row - 1] * coefficient;
+        }
+    }
+
+    void SparseSimplexBackend::ftran(std::vector<double>& a) const {
+        for (size_t k = 0; k < eta_row.size(); ++k) {
+            const int r = eta_row[k];
+            if (a[r] == 0) continue;
+            a[r] /= eta_pivot[k];
+            const double ar = a[r];
+            for (int p = eta_start[k]; p < eta_start[k + 1]; ++p) {
+                a[eta_index[p]] -= eta_value[p] * ar;
+            }
+        }
+    }
+
+    void SparseSimplexBackend::btran(std::vector<double>& y) const {
+        for (size_t k = eta_row.size(); k-- > 0;) {
+            const int r = eta_row[k];
+            double s = y[r];
+            for (int p = eta_start[k]; p < eta_start[k + 1]; ++p) {
+                s -= eta_value[p] * y[eta_index[p]];
+            }
+            y[r] = s / eta_pivot[k];
+        }
+    }
+
+    void SparseSimplexBackend::clearEtas() {
+        eta_row.clear();
+        eta_pivot.clear();
+        eta_start.assign(1, 0);
+        eta_index.clear();
+        eta_value.clear();
+        pivots_since_refactor = 0;
+    }
+
+    void SparseSimplexBackend::pushEta(int row, const std::vector<double>& column) {
+        eta_row.push_back(row);
+        eta_pivot.push_back(column[row]);
+        for (int i = 0; i < m; ++i) {
+            if (i != row && std::fabs(column[i]) > 1e-14) {
+                eta_index.push_back(i);
+                eta_value.push_back(column[i]);
+            }
+        }
+        eta_start.push_back(eta_index.size());
+    }
+
+    // Rebuilds the eta file for the basis in `head`, starting from the identity (every
+    // artificial basic) and pivoting the structural columns in, sparsest first. A column with
+    // no usable pivot makes the basis singular; its position keeps an artificial and false is
+    // returned.
+    bool SparseSimplexBackend::refactor() {
+        std::vector<char> artificial_stays(m, 0);
+        std::vector<int> structural;
+        for (int var : head) {
+            if (var >= n) artificial_stays[var - n] = 1;
+            else structural.push_back(var);
+        }
+        std::stable_sort(structural.begin(), structural.end(), [&](int a, int c) {
+            return model->columns[a].size() < model->columns[c].size();
+        });
+
+        clearEtas();
+        std::vector<char> taken(artificial_stays);
+        for (int i = 0; i < m; ++i) head[i] = n + i;
+        bool singular = false;
+        for (int q : structural) {
+            scatterColumn(q, alpha);
+            ftran(alpha);
+            int r = -1;
+            for (int i = 0; i < m; ++i) {
+                if (!taken[i] && std::fabs(alpha[i]) > kPivotTolerance && (r < 0 || std::fabs(alpha[i]) > std::fabs(alpha[r]))) r = i;
+            }
+            if (r < 0) {
+                singular = true;
+                continue;
+            }
+            pushEta(r, alpha);
+            taken[r] = 1;
+            head[r] = q;
+        }
+        std::fill(position.begin(), position.end(), -1);
+        for (int i = 0; i < m; ++i) position[head[i]] = i;
+        pivots_since_refactor = 0;
+        return !singular;
+    }
+
+    void SparseSimplexBackend::computeValues() {
+        value = b;
+        ftran(value);
+    }
+
+    void SparseSimplexBackend::computeDuals() {
+        for (int i = 0; i < m; ++i) duals[i] = cost[head[i]];
+        btran(duals);
+        for (int i = 0; i < m; ++i) signed_duals[i] = row_sign[i] * duals[i];
+    }
+
+    double SparseSimplexBackend::reducedCost(int j) const {
+        double d = cost[j];
+        for (const auto& [row, coefficient] : model->columns[j]) {
+            d -= coefficient * signed_duals[row - 1];
+        }
+        return d;
+    }
+
+    // Phase 1 minimizes the artificials that may still be positive; phase 2 has the real costs
+    void SparseSimplexBackend::setPhaseCosts(bool phase_one) {
+        cost.assign(n + m, 0.0);
+        if (phase_one) {
+            for (int i = 0; i < m; ++i) {
+                if (upper[n + i] > 0) cost[n + i] = -1.0;
+            }
+        } else {
+            for (int j = 0; j < n; ++j) cost[j] = model->objective[j];
+        }
+    }
+
+    void SparseSimplexBackend::startCold() {
+        upper.assign(n + m, kInfinity);
+        for (int i = 0; i < m; ++i) {
+            if (b[i] == 0) upper[n + i] = 0.0;
+        }
+        head.resize(m);
+        position.assign(n + m, -1);
+        for (int i = 0; i < m; ++i) {
+            head[i] = n + i;
+            position[n + i] = i;
+        }
+        clearEtas();
+        value = b;
+        setPhaseCosts(true);
+    }
+
+    // Phase 2 straight from the last optimal basis, if it is still primal feasible
+    bool SparseSimplexBackend::startWarm() {
+        upper.assign(n + m, kInfinity);
+        for (int i = 0; i < m; ++i) upper[n + i] = 0.0;
+        head.resize(m);
+        position.assign(n + m, -1);
+        for (int i = 0; i < m; ++i) {
+            const int encoded = warm_basis[i];
+            head[i] = encoded >= 0 ? encoded : n - encoded - 1;
+        }
+        if (!refactor()) return false;
+        computeValues();
+        for (int i = 0; i < m; ++i) {
+            if (value[i] < -kFeasibilityTolerance || value[i] > upper[head[i]] + kFeasibilityTolerance) return false;
+        }
+        setPhaseCosts(false);
+        return true;
+    }
+
+    SparseSimplexBackend::Outcome SparseSimplexBackend::iterate() {
+        const long iteration_limit = 20L * (m + n) + 1000;
+        int degenerate_run = 0;
+        for (long iteration = 0; iteration < iteration_limit; ++iteration) {
+            if (pivots_since_refactor >= kRefactorInterval) {
+                if (!refactor()) return Outcome::FAILED;
+                computeValues();
+            }
+
+            // Step 1: Price the nonbasic columns; artificials never re-enter
+            computeDuals();
+            const bool bland = degenerate_run >= kDegenerateRunLimit;
+            int enter = -1;
+            double best = kOptimalityTolerance;
+            for (int j = 0; j < n; ++j) {
+                if (position[j] >= 0) continue;
+                const double d = reducedCost(j);
+                if (d <= best) continue;
+                enter = j;
+                if (bland) break;
+                best = d;
+            }
+            if (enter < 0) {
+                // Confirm optimality on a fresh factorization before stopping
+                if (pivots_since_refactor == 0) return Outcome::OPTIMAL;
+                if (!refactor()) return Outcome::FAILED;
+                computeValues();
+                continue;
+            }
+
+            // Step 2: Harris ratio test. The first pass finds the largest step that keeps every
+            // basic variable within its bounds up to the tolerance, the second picks the largest
+            // pivot among the rows that block within that step.
+            scatterColumn(enter, alpha);
+            ftran(alpha);
+            double step_limit = kInfinity;
+            for (int i = 0; i < m; ++i) {
+                const double a = alpha[i];
+                if (a > kPivotTolerance) {
+                    step_limit = std::min(step_limit, (value[i] + kFeasibilityTolerance) / a);
+                } else if (a < -kPivotTolerance && upper[head[i]] < kInfinity) {
+                    step_limit = std::min(step_limit, (upper[head[i]] - value[i] + kFeasibilityTolerance) / -a);
+                }
+            }
+            if (step_limit == kInfinity) return Outcome::UNBOUNDED;
+            int leave = -1;
+            double step = 0;
+            for (int i = 0; i < m; ++i) {
+                const double a = alpha[i];
+                double ratio;
+                if (a > kPivotTolerance) ratio = value[i] / a;
+                else if (a < -kPivotTolerance && upper[head[i]] < kInfinity) ratio = (upper[head[i]] - value[i]) / -a;
+                else continue;
+                if (ratio > step_limit) continue;
+                const bool better = leave < 0 || (bland ? head[i] < head[leave] : std::fabs(a) > std::fabs(alpha[leave]));
+                if (better) {
+                    leave = i;
+                    step = std::max(0.0, ratio);
+                }
+            }
+
+            // Step 3: Pivot. The leaving variable ends at a bound of 0; an artificial that
+            // leaves is fixed there for good.
+            for (int i = 0; i < m; ++i) value[i] -= step * alpha[i];
+            value[leave] = step;
+            const int leaving = head[leave];
+            pushEta(leave, alpha);
+            head[leave] = enter;
+            position[enter] = leave;
+            position[leaving] = -1;
+            if (leaving >= n) upper[leaving] = 0.0;
+            pivots_since_refactor++;
+            degenerate_run = step <= kFeasibilityTolerance ? degenerate_run + 1 : 0;
+        }
+        return Outcome::FAILED;
+    }
+
+    LpBackend::Solution SparseSimplexBackend::delegate() {
+        delegated = true;
+        warm_basis.clear();
+        if (!fallback) fallback = makeLpBackend(LpBackendKind::GLPK_PRIMAL);
+        ModelDelta delta;
+        delta.changed.assign(model->numColumns(), 1);
+        int rewritten_columns = 0;
+        fallback->load(*model, delta, rewritten_columns);
+        Solution solution = fallback->solve();
+        solution.delegated = true;
+        return solution;
+    }
+
+    LpBackend::Solution SparseSimplexBackend::solve() {
+        Solution solution;
+        delegated = false;
+        Outcome outcome = Outcome::FAILED;
+        if (!warm_basis.empty()) {
+            if (startWarm()) outcome = iterate();
+            if (outcome == Outcome::FAILED) solution.restarted = true;
+            warm_basis.clear();
+        }
+        if (outcome == Outcome::FAILED) {
+            // Phase 1 is bounded below by 0, so anything but an optimum is a numerical failure
+            startCold();
+            if (iterate() != Outcome::OPTIMAL) return delegate();
+            double infeasibility = 0;
+            for (int i = 0; i < m; ++i) {
+                if (head[i] >= n && upper[head[i]] > 0) infeasibility += value[i];
+            }
+            if (infeasibility > kPhaseOneTolerance) return solution;
+            for (int i = 0; i < m; ++i) upper[n + i] = 0.0;
+            setPhaseCosts(false);
+            outcome = iterate();
+        }
+        if (outcome == Outcome::FAILED) return delegate();
+        if (outcome != Outcome::OPTIMAL) return solution;
+
+        solution.optimal = true;
+        solution.x.assign(n, 0.0);
+        solution.objective = 0;
+        for (int i = 0; i < m; ++i) {
+            if (head[i] < n) solution.x[head[i]] = std::max(0.0, value[i]);
+        }
+        for (int j = 0; j < n; ++j) solution.objective += model->objective[j] * solution.x[j];
+        solution.row_duals.assign(signed_duals.begin(), signed_duals.end());
+        warm_basis.resize(m);
+        for (int i = 0; i < m; ++i) warm_basis[i] = head[i] < n ? head[i] : -(head[i] - n) - 1;
+        return solution;
+    }
+
+    void SparseSimplexBackend::certify(const LinearProgramModel& model_, Solution& solution, Exact::Optimum& exact) {
+        if (delegated) fallback->certify(model_, solution, exact);
+        else LpBackend::certify(model_, solution, exact);
+    }
+}
+
+std::unique_ptr<LpBackend> makeSparseSimplexBackend() {
+    return std::make_unique<SparseSimplexBackend>();
+}
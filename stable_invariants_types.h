@@ -13,7 +13,7 @@ public:
 
 protected:
     virtual bool isValidWHGraph(const Graph& g) const {
-        const bool enough_edges = g.getAllEdges().size() >= 2;
+        const bool enough_edges = g.getNumEdges() >= 2;
         if (!enough_edges) return false;
         const bool at_least_deg_2 = g.hasMinimumDegree(2);
         if (!at_least_deg_2) return false;
@@ -40,8 +40,7 @@ protected:
         if (!normal_valid) { return false; }
         const auto& vertices = g.getVertices();
         for (const auto& vertex : vertices) {
-            const auto& incoming_outgoing = g.getNeighborVecsAtVertex(vertex);
-            if ((static_cast<int>(incoming_outgoing.first.size()) - static_cast<int>(incoming_outgoing.second.size())) % _m != 0) {
+            if ((g.getInDegree(vertex) - g.getOutDegree(vertex)) % _m != 0) {
                 return false;
             }
         }
@@ -0,0 +1,28 @@
+#!/bin/sh
+# Checks the calculator against values that have been wrong before.
+# Usage: tests/known_values.sh path/to/StablePrimitivityRankCalculator
+
+BIN=${1:?usage: $0 path/to/StablePrimitivityRankCalculator}
+failures=0
+
+# expect "<arguments>" "<expected value>"
+expect() {
+    actual=$("$BIN" single $1 < /dev/null 2>&1 | sed -n 's/^The stable primitivity rank is: //p')
+    if [ "$actual" != "$2" ]; then
+        echo "FAIL: single $1: expected $2, got ${actual:-no value}"
+        failures=$((failures + 1))
+    fi
+}
+
+# A DFS child of the vertex labelled -1 was taken for a root in the biconnectivity check, which
+# let a graph with an articulation point through and gave 1.5
+expect "2 3 -3 2 1 -3 -2 -3 -1" "2"
+
+# A primitive word was reported infinite before enumeration, but SPI_M with m = 1 is finite on it
+expect "1 3 1 -2 -2 1 -2 1" "1"
+
+if [ "$failures" -ne 0 ]; then
+    echo "$failures check(s) failed"
+    exit 1
+fi
+echo "All checks passed"
@@ -0,0 +1,60 @@
+#ifndef thread_pool_h
+#define thread_pool_h
+
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <exception>
+#include <functional>
+
+namespace Parallel {
+    // Number of workers to use when the caller asks for 0 (= all hardware threads)
+    inline int resolveThreadCount(int requested) {
+        if (requested > 0) return requested;
+        const unsigned hardware = std::thread::hardware_concurrency();
+        return hardware > 0 ? static_cast<int>(hardware) : 1;
+    }
+
+    // Runs job(i) for every i in [0, count) on up to `threads` workers. Workers claim the next
+    // unclaimed index from a shared counter, so long jobs never hold up the rest of the queue.
+    // onWorkerExit runs once on each worker thread before it finishes (e.g. to release
+    // thread-local solver state). The first exception thrown by a job is rethrown here.
+    inline void parallelFor(size_t count, int threads, const std::function<void(size_t)>& job,
+                            const std::function<void()>& onWorkerExit = nullptr) {
+        const size_t workers = std::min(static_cast<size_t>(resolveThreadCount(threads)), count);
+        if (workers <= 1) {
+            for (size_t i = 0; i < count; ++i) job(i);
+            return;
+        }
+
+        std::atomic<size_t> next(0);
+        std::exception_ptr failure;
+        std::mutex failure_mutex;
+        auto worker = [&]() {
+            try {
+                for (size_t i = next++; i < count; i = next++) {
+                    job(i);
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(failure_mutex);
+                if (!failure) failure = std::current_exception();
+                next = count; // stop handing out work
+            }
+            if (onWorkerExit) onWorkerExit();
+        };
+
+        std::vector<std::thread> pool;
+        pool.reserve(workers);
+        for (size_t t = 0; t < workers; ++t) {
+            pool.emplace_back(worker);
+        }
+        for (auto& thread : pool) {
+            thread.join();
+        }
+        if (failure) std::rethrow_exception(failure);
+    }
+}
+
+#endif
@@ -12,17 +12,22 @@
 
 namespace VariableConstruction {
     
+    // A graph is kept if every connected component is valid for the invariant
+    bool isValidUnfolding(const WhiteheadGraph& graph, StableInvariant& invariant) {
+        bool isValid = true;
+        for (const auto& component : graph.getConnectedComponents()){
+            isValid = isValid && invariant.isValidWHGraphForInvariant(component);
+        }
+        return isValid;
+    }
+
     // Function to filter the valid WhiteheadGraph objects that are visibly irreducible
     std::vector<WhiteheadGraph> filterValidWhiteheadGraphsFromPartitions(const std::vector<WhiteheadGraph>& graphs, StableInvariant& invariant) {
 
         std::vector<WhiteheadGraph> filteredGraphs;
 
         for (const auto& graph : graphs) {
-            bool isValid = true; // Initialize bool per graph
-            for (const auto& component : graph.getConnectedComponents()){
-                isValid = isValid && invariant.isValidWHGraphForInvariant(component);
-            }
-            if (isValid) {
+            if (isValidUnfolding(graph, invariant)) {
                 filteredGraphs.push_back(graph);
             }
         }
@@ -30,126 +35,168 @@ namespace VariableConstruction {
         return filteredGraphs;
     }
 
-    std::vector<std::unordered_map<int, std::vector<std::vector<int>>>> generatePartitionCombinations(
-        const std::vector<int> vertices,
-        const std::unordered_map<int, std::vector<int>>& outgoingEdges,
-        const std::unordered_map<int, std::vector<int>>& incomingEdges) {
-        
-        // Vector to store all the partition combinations for each vertex
-        std::vector<std::unordered_map<int, std::vector<std::vector<int>>>> allCombinations;
-
-        // Helper function to generate combinations recursively
-        std::function<void(int, std::unordered_map<int, std::vector<std::vector<int>>>&)> generate =
-            [&](int index, std::unordered_map<int, std::vector<std::vector<int>>>& currentCombination) {
-                if (index == vertices.size()) {
-                    // Base case: if we've processed all vertices, add the current combination to the list
-                    allCombinations.push_back(currentCombination);
-                    return;
-                }
-
-                int vertex = vertices[index];
-                auto it = outgoingEdges.find(vertex);
-                std::vector<int> edges_at_vertex = (it != outgoingEdges.end()) ? it->second: std::vector<int>();
-                it = incomingEdges.find(vertex);
-                std::vector<int> incoming = (it != incomingEdges.end()) ? it->second: std::vector<int>();
-                for (size_t i=0; i<incoming.size(); i++){
-                    incoming[i] = -incoming[i];
-                }
-                edges_at_vertex.insert(edges_at_vertex.end(), incoming.begin(), incoming.end());
-
-                // Get all possible partitions for outgoing and incoming edges
-                std::vector<std::vector<std::vector<int>>> partitions = Utils::generatePartitions(edges_at_vertex);
-
-                // Iterate over all combinations of outgoing and incoming partitions
-                for (const std::vector<std::vector<int>>& partition : partitions) {
-                    // Store the partition in the current combination
-                    currentCombination[vertex] = partition;
-
-                    // Recur to process the next vertex
-                    generate(index + 1, currentCombination);
-
-                    // Backtrack: remove the partition for the current vertex to explore other combinations
-                    currentCombination.erase(vertex);
-                }
-            };
-
-        // Initialize an empty current combination and start the recursive generation
-        std::unordered_map<int, std::vector<std::vector<int>>> currentCombination;
-        generate(0, currentCombination);
-
-        return allCombinations;
-    }
-
-    std::vector<WhiteheadGraph> partitionAndReplaceVertices(const WhiteheadGraph& originalGraph) {
-        std::vector<WhiteheadGraph> newGraphs;
-
-        // Step 1: Generate partitions for each vertex considering incoming and outgoing edges
+    // Half-edges at each vertex of the graph, in getVertices() order: outgoing edges as +position,
+    // incoming edges as -position
+    static std::vector<std::vector<int>> collectHalfEdges(const WhiteheadGraph& graph) {
         std::unordered_map<int, std::vector<int>> outgoing_vertex_to_edge_positions;
         std::unordered_map<int, std::vector<int>> incoming_vertex_to_edge_positions;
-        for (const auto& vertexEdges: originalGraph.getEdges()) {
+        for (const auto& vertexEdges: graph.getEdges()) {
             for (const std::pair<int,int> incoming_vertex_and_position: vertexEdges.second) {
                 outgoing_vertex_to_edge_positions[vertexEdges.first].push_back(incoming_vertex_and_position.second);
                 incoming_vertex_to_edge_positions[incoming_vertex_and_position.first].push_back(incoming_vertex_and_position.second);
             }
         }
 
-        std::vector<std::unordered_map<int, std::vector<std::vector<int>>>> partitionCombinations = generatePartitionCombinations(originalGraph.getVertices(), outgoing_vertex_to_edge_positions, incoming_vertex_to_edge_positions);
-
-        // Step 3: Construct new graphs based on each partition combination
-        for (const auto& partitionChoice : partitionCombinations) {
-            WhiteheadGraph newGraph(0, true);
-            std::unordered_map<int, int> position_to_new_source;
-            std::unordered_map<int, int> position_to_new_target;
-
-            // Add new vertices and track original vertices
-            int newVertexId = 0;
-            bool partition_invalid = false;
-            for (const auto& vertexPartition : partitionChoice) {
-                if (partition_invalid) { break; }
-                int originalVertex = vertexPartition.first;
-                const auto& subsets = vertexPartition.second;
-                for (const auto& subset : subsets) {
-                    if (subset.size() < 2) {partition_invalid = true; break; }
-                    newGraph.addVertex(newVertexId);
-                    newGraph.rememberOriginalVertex(originalVertex, newVertexId);
-                    for (const int position: subset){
-                        assert(position!=0 && "bug - somehow position=0"); 
-                        if (position > 0){
-                            position_to_new_source[position] = newVertexId;
-                        } else {
-                            position_to_new_target[-position] = newVertexId;
-                        }
-                    }
-                    newVertexId++;
-                }
+        const std::vector<int>& vertices = graph.getVertices();
+        std::vector<std::vector<int>> half_edges(vertices.size());
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            half_edges[i] = outgoing_vertex_to_edge_positions[vertices[i]];
+            for (const int position : incoming_vertex_to_edge_positions[vertices[i]]) {
+                half_edges[i].push_back(-position);
             }
-            if (partition_invalid) { continue; } else {
-                const bool verbose = false;
-                if (verbose) {
-                    for (const auto& vertexPartition : partitionChoice) {
-                        std::cout<<"partition for vertex: "<<vertexPartition.first<<"\n subsets: \n";
-                        const auto& subsets = vertexPartition.second;
-                        int i=0;
-                        for (const auto& subset : subsets) {
-                            i++;
-                            std::cout<<"subset "<<i<<": "<<"\n";
-                            for (const int position: subset){
-                                std::cout<<position<<",\t";
-                            }
-                            std::cout<<"\n";
-                        }
-                    }
-                }
+        }
+        return half_edges;
+    }
 
+    // Walks the cartesian product of the per-vertex partitions lazily, like an odometer whose
+    // last digit turns fastest. Only partitions without singleton blocks are generated: a
+    // singleton block would become a vertex of degree 1, which no valid unfolding contains.
+    void forEachPartitionCombination(const std::vector<std::vector<int>>& half_edges,
+                                     const std::function<void(const std::vector<Utils::SetPartitionGenerator>&)>& callback,
+                                     UnfoldingStats* stats) {
+        std::vector<Utils::SetPartitionGenerator> generators;
+        generators.reserve(half_edges.size());
+        uint64_t possible = 1;
+        bool any_combination = true;
+        for (const auto& edges_at_vertex : half_edges) {
+            generators.emplace_back(edges_at_vertex.size(), 2);
+            any_combination = any_combination && generators.back().hasPartition();
+            const size_t degree = edges_at_vertex.size();
+            const uint64_t bell = degree <= static_cast<size_t>(Utils::kMaxTabulatedBell) ? Utils::kBellNumbers[degree] : UINT64_MAX;
+            possible = (bell != 0 && possible > UINT64_MAX / bell) ? UINT64_MAX : possible * bell;
+        }
+        if (stats) stats->possible_combinations += possible;
+        if (!any_combination) return;
+
+        while (true) {
+            callback(generators);
+            if (stats) stats->generated_combinations++;
+
+            // Advance the odometer; a generator that wraps around is reset to its first partition
+            int digit = static_cast<int>(generators.size()) - 1;
+            while (digit >= 0 && !generators[digit].next()) {
+                generators[digit] = Utils::SetPartitionGenerator(half_edges[digit].size(), 2);
+                digit--;
             }
-            for (const auto& position_and_source : position_to_new_source) {
-                int targetId = position_to_new_target[position_and_source.first];
-                newGraph.addEdge(position_and_source.second, targetId, position_and_source.first);
+            if (digit < 0) return;
+        }
+    }
+
+    // Builds the graph of one partition combination: every block becomes a new vertex that
+    // remembers its original vertex, and every position joins its source and target blocks
+    static WhiteheadGraph buildUnfolding(const std::vector<int>& vertices, const std::vector<std::vector<int>>& half_edges,
+                                         const std::vector<Utils::SetPartitionGenerator>& partitions, int max_position) {
+        WhiteheadGraph newGraph(0, true);
+        std::vector<int> position_to_new_source(max_position + 1, -1);
+        std::vector<int> position_to_new_target(max_position + 1, -1);
+
+        // Add new vertices and track original vertices
+        int newVertexId = 0;
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            const Utils::SetPartitionGenerator& partition = partitions[i];
+            for (int block = 0; block < partition.numBlocks(); ++block) {
+                newGraph.addVertex(newVertexId + block);
+                newGraph.rememberOriginalVertex(vertices[i], newVertexId + block);
+            }
+            for (int k = 0; k < partition.size(); ++k) {
+                const int position = half_edges[i][k];
+                assert(position!=0 && "bug - somehow position=0");
+                if (position > 0){
+                    position_to_new_source[position] = newVertexId + partition.blockOf(k);
+                } else {
+                    position_to_new_target[-position] = newVertexId + partition.blockOf(k);
+                }
+            }
+            newVertexId += partition.numBlocks();
+        }
+
+        const bool verbose = false;
+        if (verbose) {
+            for (size_t i = 0; i < vertices.size(); ++i) {
+                std::cout<<"partition for vertex: "<<vertices[i]<<"\n blocks: ";
+                for (int k = 0; k < partitions[i].size(); ++k) {
+                    std::cout<<half_edges[i][k]<<"->"<<partitions[i].blockOf(k)<<",\t";
+                }
+                std::cout<<"\n";
             }
+        }
+
+        for (int position = 1; position <= max_position; ++position) {
+            if (position_to_new_source[position] < 0) continue;
+            newGraph.addEdge(position_to_new_source[position], position_to_new_target[position], position);
+        }
+        return newGraph;
+    }
+
+    static int maxPosition(const WhiteheadGraph& graph) {
+        int max_position = 0;
+        for (const auto& edge : graph.getEdgesByPosition()) {
+            max_position = std::max(max_position, edge.first);
+        }
+        return max_position;
+    }
+
+    void forEachUnfolding(const WhiteheadGraph& originalGraph, const std::function<void(uint64_t, const WhiteheadGraph&)>& callback, UnfoldingStats* stats) {
+        // Step 1: Collect the half-edges at each vertex
+        const std::vector<int>& vertices = originalGraph.getVertices();
+        const std::vector<std::vector<int>> half_edges = collectHalfEdges(originalGraph);
+        const int max_position = maxPosition(originalGraph);
+
+        // Step 2: Construct a new graph for each combination of per-vertex partitions
+        uint64_t index = 0;
+        forEachPartitionCombination(half_edges, [&](const std::vector<Utils::SetPartitionGenerator>& partitions) {
+            callback(index++, buildUnfolding(vertices, half_edges, partitions, max_position));
+        }, stats);
+    }
+
+    UnfoldingReplayer::UnfoldingReplayer(const WhiteheadGraph& subgraph)
+        : vertices(subgraph.getVertices()), half_edges(collectHalfEdges(subgraph)), max_position(maxPosition(subgraph)) {
+        partition_counts.reserve(half_edges.size());
+        for (const auto& edges_at_vertex : half_edges) {
+            Utils::SetPartitionGenerator generator(edges_at_vertex.size(), 2);
+            uint64_t count = generator.hasPartition() ? 1 : 0;
+            while (generator.next()) count++;
+            partition_counts.push_back(count);
+        }
+    }
 
-            newGraphs.push_back(newGraph);
+    // The index is a mixed-radix number whose digits are the positions of the per-vertex
+    // partitions, the last digit turning fastest. Each generator is stepped to its digit on its
+    // own, so the cost is the sum of the per-vertex partition counts, not the index.
+    WhiteheadGraph UnfoldingReplayer::replay(uint64_t index) const {
+        std::vector<Utils::SetPartitionGenerator> generators;
+        generators.reserve(half_edges.size());
+        for (const auto& edges_at_vertex : half_edges) {
+            generators.emplace_back(edges_at_vertex.size(), 2);
+        }
+        for (int digit = static_cast<int>(generators.size()) - 1; digit >= 0; --digit) {
+            assert(partition_counts[digit] > 0 && "unfolding index out of range");
+            for (uint64_t step = index % partition_counts[digit]; step > 0; --step) generators[digit].next();
+            index /= partition_counts[digit];
         }
+        assert(index == 0 && "unfolding index out of range");
+        return buildUnfolding(vertices, half_edges, generators, max_position);
+    }
 
+    WhiteheadGraph replayUnfolding(const WhiteheadGraph& originalGraph, uint64_t index) {
+        return UnfoldingReplayer(originalGraph).replay(index);
+    }
+
+    std::vector<WhiteheadGraph> partitionAndReplaceVertices(const WhiteheadGraph& originalGraph, UnfoldingStats* stats) {
+        std::vector<WhiteheadGraph> newGraphs;
+        forEachUnfolding(originalGraph, [&](uint64_t, const WhiteheadGraph& graph) {
+            newGraphs.push_back(graph);
+        }, stats);
         return newGraphs;
     }
-}
\ No newline at end of file
+}
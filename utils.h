@@ -2,44 +2,150 @@
 #define UTILS_H
 
 #include <vector>
+#include <array>
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
 
 namespace Utils{
-    // Helper function to generate all partitions of a set
+    // Bell numbers B(0)..B(kMaxTabulatedBell), built at compile time with the Bell triangle
+    constexpr int kMaxTabulatedBell = 25;
+    constexpr std::array<uint64_t, kMaxTabulatedBell + 1> makeBellTable() {
+        std::array<uint64_t, kMaxTabulatedBell + 1> bell{};
+        std::array<uint64_t, kMaxTabulatedBell + 1> row{};
+        std::array<uint64_t, kMaxTabulatedBell + 1> next{};
+        bell[0] = 1;
+        row[0] = 1;
+        for (int n = 1; n <= kMaxTabulatedBell; ++n) {
+            next[0] = row[n - 1];
+            for (int k = 1; k <= n; ++k) {
+                next[k] = next[k - 1] + row[k - 1];
+            }
+            bell[n] = next[0];
+            row = next;
+        }
+        return bell;
+    }
+    constexpr std::array<uint64_t, kMaxTabulatedBell + 1> kBellNumbers = makeBellTable();
+    static_assert(kBellNumbers[10] == 115975, "Bell table is wrong");
+
+    // Lazily enumerates the set partitions of {0, ..., n-1} whose blocks all have at least
+    // min_block_size elements, as restricted growth strings: element i lies in block blockOf(i),
+    // with blockOf(0) = 0 and every block index at most one more than the largest index before
+    // it. Strings come in lexicographic order, which is the order in which the old recursive
+    // generator emitted partitions. A branch is abandoned as soon as the remaining elements
+    // cannot fill every undersized block, so partitions that break the size rule are never
+    // visited. Advancing never allocates.
+    class SetPartitionGenerator {
+    public:
+        explicit SetPartitionGenerator(int n_, int min_block_size_ = 1)
+            : n(n_), min_block_size(min_block_size_), block(n_, 0), block_size(n_, 0) {
+            has_partition = search(0, 0);
+        }
+
+        bool hasPartition() const { return has_partition; }
+        int size() const { return n; }
+        int blockOf(int element) const { return block[element]; }
+        int numBlocks() const { return num_blocks; }
+
+        // Moves to the next partition; returns false once every partition has been visited
+        bool next() {
+            if (!has_partition || n == 0) return false;
+            const int last = n - 1;
+            const int value = block[last];
+            unplace(last);
+            return search(last, value + 1);
+        }
+
+    private:
+        int n;
+        int min_block_size;
+        std::vector<int> block;      // restricted growth string
+        std::vector<int> block_size; // number of elements in each open block
+        int num_blocks = 0;
+        int deficit = 0;             // elements still needed to bring every block up to min_block_size
+        bool has_partition = false;
+
+        void place(int element, int value) {
+            block[element] = value;
+            if (value == num_blocks) num_blocks++;
+            const int before = block_size[value]++;
+            if (before == 0) deficit += std::max(0, min_block_size - 1);
+            else if (before < min_block_size) deficit--;
+        }
+
+        void unplace(int element) {
+            const int value = block[element];
+            const int after = --block_size[value];
+            if (after == 0) { deficit -= std::max(0, min_block_size - 1); num_blocks--; }
+            else if (after < min_block_size) deficit++;
+        }
+
+        // Fills positions element..n-1 with the lexicographically smallest feasible values,
+        // starting position `element` at `value`; backtracks into earlier positions as needed
+        bool search(int element, int value) {
+            if (n == 0) return true;
+            while (element >= 0) {
+                bool placed = false;
+                for (int v = value; v <= num_blocks && !(element == 0 && v > 0); ++v) {
+                    place(element, v);
+                    if (deficit <= n - 1 - element) { placed = true; break; }
+                    unplace(element);
+                }
+                if (placed) {
+                    if (element == n - 1) return true;
+                    element++;
+                    value = 0;
+                } else {
+                    element--;
+                    if (element >= 0) {
+                        value = block[element] + 1;
+                        unplace(element);
+                    }
+                }
+            }
+            return false;
+        }
+    };
+
+    // Writes the generator's current partition of `set_to_partition` into `partition`,
+    // reusing the capacity of its blocks
     template <typename T>
-    void generatePartitionsHelper(const std::vector<T>& set_to_partition,
-                                std::vector<std::vector<T>> currentPartition,
-                                std::vector<std::vector<std::vector<T>>>& allPartitions,
-                                int index) {
-        if (index == set_to_partition.size()) {
-            allPartitions.push_back(currentPartition);
-            return;
-        }
-
-        const T element = set_to_partition[index];
-        const int current_partition_size_before = currentPartition.size();
-        // Try to add the current element to existing subsets
-        for (int i = 0; i < current_partition_size_before; ++i) {
-            auto& subset = currentPartition[i];
-            subset.push_back(element);
-            generatePartitionsHelper(set_to_partition, currentPartition, allPartitions, index + 1);
-            subset.pop_back();
-        }
-
-        // Try to create a new subset with the current element
-        currentPartition.push_back({element});
-        generatePartitionsHelper(set_to_partition, currentPartition, allPartitions, index + 1);
-        currentPartition.pop_back();
+    void assignPartition(const SetPartitionGenerator& generator, const std::vector<T>& set_to_partition,
+                         std::vector<std::vector<T>>& partition) {
+        const int num_blocks = generator.numBlocks();
+        partition.resize(num_blocks);
+        for (auto& subset : partition) subset.clear();
+        for (int i = 0; i < generator.size(); ++i) {
+            partition[generator.blockOf(i)].push_back(set_to_partition[i]);
+        }
+    }
+
+    // Calls callback(partition) for every partition of the set whose blocks have at least
+    // min_block_size elements; the partition is rebuilt in place
+    template <typename T, typename Callback>
+    void forEachPartition(const std::vector<T>& set_to_partition, Callback&& callback, int min_block_size = 1) {
+        SetPartitionGenerator generator(set_to_partition.size(), min_block_size);
+        if (!generator.hasPartition()) return;
+        std::vector<std::vector<T>> partition;
+        do {
+            assignPartition(generator, set_to_partition, partition);
+            callback(static_cast<const std::vector<std::vector<T>>&>(partition));
+        } while (generator.next());
     }
 
     // Wrapper function to generate all partitions
     template <typename T>
     std::vector<std::vector<std::vector<T>>> generatePartitions(const std::vector<T>& set_to_partition) {
         std::vector<std::vector<std::vector<T>>> partitions;
-        std::vector<std::vector<T>> currentPartition;
-        generatePartitionsHelper(set_to_partition, currentPartition, partitions, 0);
+        if (set_to_partition.size() <= 12) { // B(12) = 4213597
+            partitions.reserve(kBellNumbers[set_to_partition.size()]);
+        }
+        forEachPartition(set_to_partition, [&](const std::vector<std::vector<T>>& partition) {
+            partitions.push_back(partition);
+        });
         return partitions;
     }
 }
 
-#endif
\ No newline at end of file
+#endif
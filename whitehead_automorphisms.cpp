@@ -1,4 +1,8 @@
 #include "whitehead_automorphisms.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
 
 // Function to compute the inverse of a word
 Word invert_word(const Word& w) {
@@ -147,3 +151,107 @@ Word get_minimal_word(const Word& input_word, int r){
     
     return current;
 }
+
+// A word is cyclically reduced if it is reduced and its last letter does not cancel its first
+bool is_cyclically_reduced(const Word& word){
+    for(size_t i = 1; i < word.size(); ++i){
+        if(word[i] == -word[i-1]) return false;
+    }
+    return word.size() < 2 || word.back() != -word.front();
+}
+
+// Relabels the cyclic word read from `start` in direction `step` (+1 forwards, -1 backwards
+// through the inverse) so that generators are numbered, and signed, by first appearance
+static Word relabel_by_first_appearance(const Word& word, size_t start, int step, int max_generator){
+    const int n = word.size();
+    vector<int> image(max_generator + 1, 0); // generator -> signed new generator
+    int next_generator = 1;
+    Word relabeled(n);
+    for(int k = 0; k < n; ++k){
+        const int index = ((static_cast<int>(start) + step * k) % n + n) % n;
+        const int letter = step > 0 ? word[index] : -word[index];
+        const int gen = abs(letter);
+        if(image[gen] == 0){
+            image[gen] = letter > 0 ? next_generator : -next_generator;
+            next_generator++;
+        }
+        relabeled[k] = letter > 0 ? image[gen] : -image[gen];
+    }
+    return relabeled;
+}
+
+// Letter order used for canonical forms: 1 < -1 < 2 < -2 < ...
+static bool letter_less(int a, int b){
+    const int key_a = 2 * abs(a) + (a < 0);
+    const int key_b = 2 * abs(b) + (b < 0);
+    return key_a < key_b;
+}
+
+// Minimal representative of a cyclically reduced word under rotation, inversion and signed
+// permutation of the generators (the Type I Whitehead automorphisms). For a fixed starting
+// point and direction, numbering generators by first appearance already gives the minimal
+// relabeling, so only the 2|w| starting points have to be compared.
+Word canonical_cyclic_word(const Word& word){
+    if(word.empty()) return word;
+    int max_generator = 0;
+    for(auto c : word) max_generator = max(max_generator, abs(c));
+
+    Word best;
+    for(size_t start = 0; start < word.size(); ++start){
+        for(int step : {1, -1}){
+            Word candidate = relabel_by_first_appearance(word, start, step, max_generator);
+            if(best.empty() || lexicographical_compare(candidate.begin(), candidate.end(), best.begin(), best.end(), letter_less)){
+                best = move(candidate);
+            }
+        }
+    }
+    return best;
+}
+
+// Number of cyclically reduced words of the same length in F_r that have the given canonical
+// word as their canonical form: |G| / |stabilizer| for G = rotations x inversion x signed
+// permutations. A rotation or inversion fixes the word up to relabeling exactly when it
+// relabels to the word itself; generators the word does not use can then be permuted freely.
+long long cyclic_orbit_size(const Word& canonical_word, int r){
+    const int n = canonical_word.size();
+    if(n == 0) return 1;
+    int used = 0;
+    for(auto c : canonical_word) used = max(used, abs(c));
+
+    long long matches = 0;
+    for(int start = 0; start < n; ++start){
+        for(int step : {1, -1}){
+            if(relabel_by_first_appearance(canonical_word, start, step, used) == canonical_word) matches++;
+        }
+    }
+    // 2^(r-used) (r-used)! of the 2^r r! signed permutations fix the unused generators' slots
+    long long relabelings_of_used = 1;
+    for(int k = r - used + 1; k <= r; ++k) relabelings_of_used *= 2 * k;
+    return 2 * n * relabelings_of_used / matches;
+}
+
+// Canonical forms (see canonical_cyclic_word) of all cyclically reduced words of the given
+// length in F_r, i.e. one word per orbit. Words are built with generators numbered and signed
+// by first appearance, so only the rotation and inversion part of the check is left to do.
+vector<Word> generate_canonical_cyclic_words(int length, int r){
+    vector<Word> canonical_words;
+    if(length <= 0) return canonical_words;
+    Word word(length);
+    function<void(int, int)> extend = [&](int position, int used){
+        if(position == length){
+            if(length >= 2 && word.back() == -word.front()) return;
+            if(canonical_cyclic_word(word) == word) canonical_words.push_back(word);
+            return;
+        }
+        for(int gen = 1; gen <= min(used + 1, r); ++gen){
+            for(int letter : {gen, -gen}){
+                if(gen == used + 1 && letter < 0) continue; // first appearance is positive
+                if(position > 0 && letter == -word[position - 1]) continue;
+                word[position] = letter;
+                extend(position + 1, max(used, gen));
+            }
+        }
+    };
+    extend(0, 0);
+    return canonical_words;
+}
@@ -1,3 +1,6 @@
+#ifndef whitehead_automorphisms_h
+#define whitehead_automorphisms_h
+
 #include <vector>
 
 using namespace std;
@@ -12,4 +15,10 @@ struct Automorphism {
 };
 Word get_minimal_word(const Word& input_word, int r);
 bool is_minimal(const Word& word, int r, const vector<Automorphism>& automorphisms);
-vector<Automorphism> generate_typeII(int r);
\ No newline at end of file
+vector<Automorphism> generate_typeII(int r);
+bool is_cyclically_reduced(const Word& word);
+Word canonical_cyclic_word(const Word& word);
+long long cyclic_orbit_size(const Word& canonical_word, int r);
+vector<Word> generate_canonical_cyclic_words(int length, int r);
+
+#endif